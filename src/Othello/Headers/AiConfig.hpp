@@ -0,0 +1,51 @@
+//
+//  AiConfig.hpp
+//  Othello
+//
+//  The AI's default settings, shared by the game, othello-cli and othello-bench so they all play (and measure) the same AI.
+//
+
+#ifndef AiConfig_hpp
+#define AiConfig_hpp
+
+#include "AiMind.hpp"
+#include <memory>
+
+namespace othello {
+
+    /// Weights of the hand-tuned evaluation (Evaluator::WEIGHTS, and the pattern tables' starting point), for each factor based on its importance.
+    const unsigned int NUM_DISC_WEIGHT = 3;
+    const unsigned int MOBILITY_WEIGHT = 1;
+    const unsigned int STABILITY_WEIGHT = 2;
+    const unsigned int CORNER_WEIGHT = 4;
+    const int NUM_FRONTIER_WEIGHT = -1;
+    const int CORNER_ADJ_WEIGHT = -2;
+
+    /// Limits on the AI's search for each move: it searches deeper and deeper until it runs out of time (or reaches the max depth),
+    /// so an AI turn takes about the same time from opening to endgame.
+    const unsigned int MAX_SEARCH_DEPTH = 60;
+    const double AI_SECS_PER_MOVE = 1.0;
+    const uint64_t AI_NODES_PER_MOVE = 0; // 0 = no node limit
+
+    /// Transposition table settings for the AI (the table is kept from move to move).
+    const size_t TT_SIZE_MB = 64;
+    const ReplacementPolicy TT_POLICY = ReplacementPolicy::TWO_TIER;
+
+    /// Threads the AI searches with (0 = one per hardware thread).
+    const unsigned int AI_SEARCH_THREADS = 0;
+
+    /// Whether the AI also counts leaf evaluations and cutoffs per ply for its search report (nodes & iteration times are always counted).
+    const bool AI_SEARCH_STATS = true;
+
+    /// Evaluation the AI searches with (Evaluator::WEIGHTS = the hand-tuned weights above), and trained pattern tables to load if present.
+    const Evaluator AI_EVALUATOR = Evaluator::PATTERNS;
+    const char* const EVAL_PATH = "othello.eval";
+
+    /// Opening book the AI plays from before it starts searching (written by "othello-cli --build-book").
+    const char* const BOOK_PATH = "othello.book";
+
+    /// Creates an AI with the weights & settings above. The pattern tables and opening book are left for the caller to load.
+    std::shared_ptr<AiMind> makeDefaultMind();
+}
+
+#endif /* AiConfig_hpp */
@@ -8,10 +8,21 @@
 #ifndef AiMind_hpp
 #define AiMind_hpp
 
-#include "Board.hpp"
-#include "Player.hpp"
-#include "Tile.hpp"
-#include "GameState.hpp"
+#include "Position.hpp"
+#include "TranspositionTable.hpp"
+#include "MoveOrdering.hpp"
+#include "ThreadPool.hpp"
+#include "EndgameSolver.hpp"
+#include "OpeningBook.hpp"
+#include "PatternEval.hpp"
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
 
 namespace othello {
 
@@ -22,7 +33,7 @@ namespace othello {
         /// Score based on mobility, which represents the amount of possible moves the player has.
         unsigned int mobilityScore;
         
-        /// Score based on stability, which represents how many of the player's tiles aren't currently flanked (can't be flipped) by their opponent.
+        /// Score based on stability, which represents how many of the player's tiles can never be flipped by their opponent.
         unsigned int stabilityScore;
         
         /// Score based on how many corner pieces the player has.
@@ -43,6 +54,146 @@ namespace othello {
         }
     };
 
+    /// Which evaluation scores the leaves of the search.
+    enum class Evaluator {
+        /// Pattern tables (see PatternEvaluator).
+        PATTERNS,
+        /// The hand-tuned weights, feature by feature.
+        WEIGHTS
+    };
+
+    /// Larger than any score the evaluation can return; search windows start at (-SCORE_INFINITY, SCORE_INFINITY).
+    const int SCORE_INFINITY = 1000000;
+
+    /// Limits on a single move's iterative-deepening search. The search stops at whichever runs out first.
+    struct SearchLimits {
+        /// Deepest iteration to search.
+        unsigned int maxDepth;
+        
+        /// Wall-clock budget in seconds (0 = no time limit).
+        double maxSeconds;
+        
+        /// Budget of minimax nodes (0 = no node limit).
+        uint64_t maxNodes;
+        
+        /// If set, the search stops (throwing away the unfinished iteration) soon after this flag becomes true.
+        /// Unlike the other limits it can stop the first iteration too, so the returned move is only meaningful if the flag stayed false.
+        const std::atomic<bool>* stopFlag = nullptr;
+    };
+    
+    /// How far a running search has got. Read with AiMind::getProgress() from any thread.
+    struct SearchProgress {
+        /// Iterations finished so far (the deepest finished one searched depth iterationsDone - 1).
+        unsigned int iterationsDone;
+        
+        /// Best move (square) of the deepest finished iteration, or NO_SQUARE before the first one finishes.
+        int bestMove;
+        
+        /// Nodes searched so far (approximate, counted in batches).
+        uint64_t nodes;
+    };
+
+    /// One iteration of iterative deepening that finished.
+    struct IterationInfo {
+        unsigned int depth;
+        
+        /// Nodes this iteration visited over all threads, aspiration re-searches included.
+        uint64_t nodes;
+        
+        /// Wall-clock time of this iteration alone.
+        double seconds;
+        
+        /// Score of its best move, from the AI's point of view.
+        int score;
+    };
+    
+    /// Search counters at one distance from the root, over all threads & iterations.
+    struct PlyStats {
+        /// Nodes visited at this ply.
+        uint64_t nodes;
+        
+        /// Nodes where a move caused a beta cutoff.
+        uint64_t cutoffs;
+        
+        /// Cutoffs caused by the first move tried.
+        uint64_t firstMoveCutoffs;
+    };
+
+    /// What the last search did.
+    struct SearchInfo {
+        /// Depth of the deepest iteration that finished.
+        unsigned int depthReached;
+        
+        /// Minimax nodes visited over all iterations.
+        uint64_t nodes;
+        
+        /// How many of those nodes each search thread visited.
+        std::vector<uint64_t> threadNodes;
+        
+        /// Wall-clock time the whole search took.
+        double seconds;
+        
+        /// Score of the chosen move, from the AI's point of view.
+        int score;
+        
+        /// Expected line of play (squares), starting with the chosen move.
+        std::vector<int> principalVariation;
+        
+        /// Whether the endgame solver chose the move. The score is then the final disc difference instead of an evaluation
+        /// (for a win/loss/draw solve only its sign means anything), and depthReached is the number of empty squares.
+        bool solved;
+        
+        /// Whether the move came from the opening book. The score and depthReached are then those the book was built with, and nodes is 0.
+        bool fromBook;
+        
+        /// Iterations that finished, shallowest first (empty for book moves & solved positions).
+        std::vector<IterationInfo> iterations;
+        
+        /// Whether the counters below were collected (see AiMind::setSearchStats); they're 0 / empty otherwise.
+        bool detailed;
+        
+        /// Leaves scored with the evaluation.
+        uint64_t leafEvaluations;
+        
+        /// Counters per distance from the root, up to the deepest ply reached (index 1 = the positions after the root moves).
+        std::vector<PlyStats> plies;
+        
+        /// Transposition table counters of this search alone (the table's own keep adding up from search to search).
+        TTStats table;
+        
+        /// Nodes visited per second of the whole search.
+        inline double nodesPerSecond() const {
+            return (seconds > 0) ? nodes / seconds : 0.0;
+        }
+        
+        /// Branching factor b of a uniform tree as big as the deepest iteration: nodes = b^plies, counting the root moves' ply
+        /// (0 if no iteration finished). Not a ratio between iterations, which a table kept from earlier moves makes meaningless.
+        inline double effectiveBranchingFactor() const {
+            if (iterations.empty() || (iterations.back().nodes == 0))
+                return 0.0;
+            return std::pow((double)iterations.back().nodes, 1.0 / (iterations.back().depth + 1));
+        }
+        
+        /// Beta cutoffs at every ply.
+        inline uint64_t cutoffs() const {
+            uint64_t total = 0;
+            for (const PlyStats& ply : plies) {
+                total += ply.cutoffs;
+            }
+            return total;
+        }
+        
+        /// Fraction of cutoffs (at every ply) that happened on the first move tried.
+        inline double firstMoveCutoffRate() const {
+            uint64_t total = 0, first = 0;
+            for (const PlyStats& ply : plies) {
+                total += ply.cutoffs;
+                first += ply.firstMoveCutoffs;
+            }
+            return total ? (double)first / total : 0.0;
+        }
+    };
+
     class AiMind {
     private:
         // weights for each factor based on their importance
@@ -54,18 +205,233 @@ namespace othello {
         const int CORNER_ADJ_WEIGHT_;
         const unsigned int NUM_DISC_WEIGHT_;
         
-        RGBColor DEFAULT_TILE_COLOR_;
+        /// A node whose moves several threads are searching (defined in AiMind.cpp).
+        struct SplitPoint;
         
-        static RGBColor WHITE, BLACK;
+        /// Everything a search thread changes while searching, so several threads can search the same root at once.
+        /// Each thread makes & unmakes moves on its own copy of the root position.
+        struct SearchThread {
+            Position pos;
+            
+            /// Zobrist hash of 'pos' (plus the AI's perspective, see bestMove), updated by makeMove_/unmakeMove_.
+            uint64_t hash;
+            
+            /// Pattern indices of 'pos', updated by makeMove_/unmakeMove_ so leaves are scored without scanning the board.
+            EvalState evalState;
+            
+            /// Moves made on 'pos' that still need to be taken back, innermost last.
+            /// Reserved up front so searching never allocates.
+            std::vector<MoveUndo> undoStack;
+            
+            /// Distance from the root of the position at the bottom of undoStack (non-zero while helping at another thread's split point).
+            int plyBase;
+            
+            /// Innermost split point this thread is searching moves of (null if none).
+            /// If it or any split point above it is cancelled, the thread stops searching.
+            SplitPoint* activeSplit;
+            
+            /// Split points this thread owns that others can still join, oldest (nearest the root) first.
+            /// The owner pushes & pops at the back, other threads steal from the front.
+            std::deque<SplitPoint*> splits;
+            std::mutex splitsMutex;
+            
+            /// Orders the moves at each node (killer & history tables persist for the whole search).
+            MoveOrderer orderer;
+            
+            /// Triangular principal variation table: pvTable[ply] holds the best line found from 'ply' onwards, pvLength[ply] is where it ends.
+            int pvTable[NUM_SQUARES + 1][NUM_SQUARES + 1];
+            unsigned int pvLength[NUM_SQUARES + 1];
+            
+            /// Nodes this thread visited in the current search.
+            uint64_t nodes;
+            
+            /// This thread's leaf & per-ply counters for the current search, only kept while searchStats_ is set (added up into lastSearch_ at the end).
+            uint64_t leafEvals;
+            PlyStats plyStats[NUM_SQUARES + 1];
+            
+            /// This thread's transposition table counters, added to the table's totals after each search.
+            TTStats ttStats;
+            
+            SearchThread();
+            
+            /// Distance of 'pos' from the root.
+            inline unsigned int ply() const {
+                return (unsigned int)(plyBase + (int)undoStack.size());
+            }
+        };
         
-        /// Helper function for minimax used to create a new gamestate object and place each hypothetical piece
-        /// @param maxing Which mode minimax is currently in (maximizing or not).
-        /// @param depth The current depth of the minimax tree, where 0 is a leaf node.
-        /// @param thisMove The location of the new hypothetical move.
-        /// @param oldBoard The board as it was before placing the new hypothetical move.
-        /// @param alpha The current value for alpha (max) for minimax's alpha-beta pruning.
-        /// @param beta The current value for beta (min) for minimax's alpha-beta pruning.
-        int applyMinimaxMove_(bool maxing, unsigned int depth, std::shared_ptr<Tile>& thisMove, std::shared_ptr<Board>& oldBoard, int alpha, int beta);
+        /// The state shared by the threads searching one root window (defined in AiMind.cpp).
+        struct RootSearch;
+        
+        /// One SearchThread per search thread; the first one is also used by negamax() & single-threaded searches.
+        std::vector<std::unique_ptr<SearchThread>> threads_;
+        
+        /// Runs the root moves in parallel (null when searching with one thread).
+        std::unique_ptr<ThreadPool> threadPool_;
+        
+        /// Positions searched so far (kept across turns, shared by all search threads).
+        TranspositionTable transTable_;
+        
+        /// Root of the search in progress, and its hash.
+        Position rootPos_;
+        uint64_t rootHash_;
+        
+        /// Budget bookkeeping for the search in progress.
+        /// Threads add their node counts to sharedNodes_ every so often, so the node limit is checked against all threads.
+        std::atomic<uint64_t> sharedNodes_;
+        uint64_t nodeLimit_;
+        bool hasDeadline_;
+        std::chrono::steady_clock::time_point deadline_;
+        const std::atomic<bool>* stopFlag_;
+        
+        /// What getProgress() reports, updated as iterations finish.
+        std::atomic<unsigned int> iterationsDone_;
+        std::atomic<int> progressBestMove_;
+        
+        /// Threads looking for work; nodes are only split while some thread is waiting to help.
+        std::atomic<int> idleThreads_;
+        
+        /// Threads with nothing to take sleep on workAvailable_ until workEpoch_ changes (it's only changed with workMutex_ held).
+        std::atomic<uint64_t> workEpoch_;
+        std::mutex workMutex_;
+        std::condition_variable workAvailable_;
+        
+        /// Set once the search runs out of budget; every node then returns straight away and the unfinished iteration is thrown out.
+        std::atomic<bool> searchAborted_;
+        
+        /// Budgets are only enforced once an iteration has finished, so there's always a move to return.
+        bool canAbort_;
+        
+        SearchInfo lastSearch_;
+        
+        /// Whether searches count leaves & cutoffs per ply (see setSearchStats).
+        bool searchStats_;
+        
+        /// Solves positions near the end of the game outright, instead of searching them with the evaluation.
+        EndgameSolver endgameSolver_;
+        
+        /// Positions with at most this many empty squares are solved exactly / for win, loss or draw.
+        unsigned int exactSolveEmpties_;
+        unsigned int winLossDrawSolveEmpties_;
+        
+        /// Book consulted before searching (null = always search).
+        std::shared_ptr<const OpeningBook> openingBook_;
+        
+        /// Scores leaves with pattern tables, seeded from the weights above.
+        PatternEvaluator patternEval_;
+        Evaluator evaluator_;
+        
+        /// OrderingStage flags given to every thread's move orderer.
+        unsigned int orderingStages_;
+        
+        /// Cutoff statistics of every thread's move orderer, over all searches.
+        OrderingStats orderingStats_;
+        
+        /// Share of the time budget the endgame solver gets; if it doesn't finish, the search uses the rest.
+        static const double SOLVE_TIME_SHARE_;
+        
+        /// Half-width of the aspiration window each iteration starts with, around the previous iteration's score.
+        static const int ASPIRATION_WINDOW_;
+        
+        /// Nodes with less remaining depth than this are always searched by a single thread.
+        static const unsigned int MIN_SPLIT_DEPTH_;
+        
+        /// Scores thread 't''s position (a leaf) for the side to move, MOVER (the evaluation itself is always from the AI's point of view, so the sign is a constant).
+        template <Side AI_SIDE, Side MOVER>
+        int leafScore_(SearchThread& t);
+        
+        /// The hand-tuned evaluation (Evaluator::WEIGHTS): forWho's own gamestate advantage score.
+        int evalWeights_(const Position& pos, Side forWho);
+        
+        /// The search itself (see negamax()), on thread 't''s position: picks the instantiation of the one below for aiSide & the side to move.
+        int negamax_(SearchThread& t, unsigned int depth, Side aiSide, int alpha, int beta);
+        
+        /// The search, instantiated per AI side & side to move (MOVER, which must be t.pos.toMove). Each ply calls the opposite mover's instantiation,
+        /// so disc indices, leaf score signs and move bookkeeping are fixed at compile time instead of looked up at every node.
+        template <Side AI_SIDE, Side MOVER>
+        int negamax_(SearchThread& t, unsigned int depth, int alpha, int beta);
+        
+        /// Searches every root move with principal variation search inside the window (alpha, beta), spread over the search threads.
+        /// Returns the best score (a bound if it falls outside the window) and sets bestInd to the best move's index.
+        /// Ties always go to the move listed first in rootMoves. With one thread and the same table contents the result is always the same;
+        /// with more, threads can find each other's deeper table entries in a different order, which can change (never worsen) the result.
+        /// @param aiSide The side we're computing the best move for (to move at rootPos_).
+        /// @param rootMoves Squares of the root moves, in possibleMoves order.
+        /// @param searchOrder Indices into rootMoves in the order to search them.
+        /// @param moveScores Filled with each root move's score (exact for the best move, a bound for the others).
+        /// @param depth Search depth below each root move.
+        /// @param alpha Lower bound of the window.
+        /// @param beta Upper bound of the window.
+        /// @param bestInd Set to the index (into rootMoves) of the best move.
+        /// @param pv Set to the best move's principal variation.
+        int searchRoot_(Side aiSide, const std::vector<int>& rootMoves, const std::vector<unsigned int>& searchOrder, std::vector<int>& moveScores, unsigned int depth, int alpha, int beta, unsigned int& bestInd, std::vector<int>& pv);
+        
+        /// Tries to solve rootPos_ with the endgame solver, if it has few enough empties. Returns false if it doesn't or can't
+        /// within the limits (the stop flag, or its share of the time budget).
+        /// @param bestInd Set to the index (into rootMoves) of the best move.
+        bool solveEndgame_(const std::vector<int>& rootMoves, const SearchLimits& limits, std::chrono::steady_clock::time_point startTime, unsigned int& bestInd);
+        
+        /// Looks rootPos_ up in the opening book. Returns false if there's no book, the position isn't in it, or its move isn't in rootMoves.
+        /// @param bestInd Set to the index (into rootMoves) of the book move.
+        bool probeBook_(const std::vector<int>& rootMoves, unsigned int& bestInd);
+        
+        /// Searches root move 'i' on thread 't', against the best score found so far by any thread.
+        void searchRootMove_(SearchThread& t, RootSearch& root, unsigned int i);
+        
+        /// Takes root moves, or helps at other threads' split points, until every root move is finished.
+        void helperLoop_(SearchThread& t, RootSearch& root);
+        
+        /// Whether thread 't''s current result is no longer needed: the search is out of budget, or a split point it is under was cut off.
+        bool stopped_(const SearchThread& t) const;
+        
+        /// Shares out the remaining moves of the node thread 't' is at (its first move already searched), and searches them along with
+        /// any idle threads that join. Updates alpha, bestScore & bestMove (and the PV) as the move loop in negamax_ would.
+        void splitSearch_(SearchThread& t, unsigned int depth, Side aiSide, int& alpha, int beta, int& bestScore, int& bestMove, const ScoredMove* moves, unsigned int numMoves);
+        
+        /// Searches moves of split point 'sp' until none are left or it is cut off.
+        void searchSplitMoves_(SearchThread& t, SplitPoint& sp);
+        
+        /// Joins another thread's split point (already counted in its helpers by trySteal_), then goes back to what 't' was doing.
+        void helpSplit_(SearchThread& t, SplitPoint& sp);
+        
+        /// Finds a split point with moves left and joins it. Returns null if there is none.
+        /// @param within If set, only split points below this one are considered (an owner waiting on its helpers only helps them).
+        SplitPoint* trySteal_(const SplitPoint* within);
+        
+        /// Wakes every thread in waitForWork_: called whenever there's something new to take (a split point, root moves) or to stop waiting for.
+        void signalWork_();
+        
+        /// Sleeps until signalWork_ has been called since workEpoch_ read 'epoch' (at once if it already has).
+        void waitForWork_(uint64_t epoch);
+        
+        /// Resets thread 't' to the root position.
+        void resetThread_(SearchThread& t, const Position& pos, uint64_t hash);
+        
+        /// Adds every thread's transposition table & ordering counters to the totals, and resets them.
+        void collectThreadStats_();
+        
+        /// Counts a node and checks (every so often) whether the search has run out of budget.
+        void countNode_(SearchThread& t);
+        
+        /// Counts a beta cutoff at 'ply' by the move tried at 'moveIndex', if searchStats_ is set.
+        void countCutoff_(SearchThread& t, unsigned int ply, unsigned int moveIndex);
+        
+        /// Adds up the threads' leaf & per-ply counters into lastSearch_.
+        void collectSearchStats_();
+        
+        /// Plays 'sq' for 'mover' on thread 't''s position and records it on its undo stack.
+        void makeMove_(SearchThread& t, Side mover, int sq);
+        
+        /// Same, for a mover known at compile time (MOVER must be t.pos.toMove).
+        template <Side MOVER>
+        void makeMove_(SearchThread& t, int sq);
+        
+        /// Takes back the last move recorded on thread 't''s undo stack.
+        void unmakeMove_(SearchThread& t);
+        
+        /// Same, when MOVER is known to have made it.
+        template <Side MOVER>
+        void unmakeMove_(SearchThread& t);
         
     public:
         /// Creates a new AI object.
@@ -76,33 +442,124 @@ namespace othello {
         /// @param cornerWeight Weight for number of corner pieces a player has.
         /// @param cornerAdjWeight Weight for number of corner-adjacent tiles a player has.
         /// @param frontierWeight Weight for the number of blank tiles next to a player's tiles.
-        /// @param defaultTileCol The default 'green' color of the game board.
-        AiMind(unsigned int discWeight, unsigned int mobilityWeight, unsigned int stabilityWeight, unsigned int cornerWeight, int cornerAdjWeight, int frontierWeight, RGBColor defaultTileCol);
+        AiMind(unsigned int discWeight, unsigned int mobilityWeight, unsigned int stabilityWeight, unsigned int cornerWeight, int cornerAdjWeight, int frontierWeight);
+        
         
+        /// Negamax alpha-beta search with principal variation search: the first move at each node is searched with the full window,
+        /// the others with a null window that only proves they're no better, and are re-searched if they turn out to be.
+        /// Scores are from the point of view of the side to move. Moves are made & unmade in place on a copy of 'pos', so no heap memory is used while searching.
+        /// Runs on the calling thread.
+        /// @param depth The current depth of the search tree, where 0 is a leaf node.
+        /// @param pos The position to search from (pos.toMove is the side to move).
+        /// @param aiSide The side we're computing the best move for (whose evaluation is used).
+        /// @param alpha Score the side to move is already guaranteed elsewhere.
+        /// @param beta Score the opponent is already guaranteed elsewhere (anything at or above it gets cut off).
+        int negamax(unsigned int depth, const Position& pos, Side aiSide, int alpha, int beta);
         
-        /// MiniMax search algorithm implimentation, used as a general heuristic for measuring a player's position as a score.
-        /// @param maximizing Which mode minimax is currently in (maximizing or minimizing).
+        /// MiniMax search, used as a general heuristic for measuring a player's position as a score.
+        /// Runs negamax() and converts its score to the AI's point of view.
+        /// @param maximizing Which mode minimax is currently in (maximizing = AI to move, or minimizing).
         /// @param depth The current depth of the minimax tree, where 0 is a leaf node.
-        /// @param aiPlayer Reference to the player object who we're computing the best move for.
-        /// @param opponent The opposing player.
-        /// @param thisBoard The current board we're computing the best next move on.
-        /// @param layout The reference to the board and gamestate.
+        /// @param pos The position to search from.
+        /// @param aiSide The side we're computing the best move for (the maximizing side).
         /// @param alpha Max value kept for alpha-beta pruning.
         /// @param beta Min value for alpha-beta pruning.
-        int minimax(bool maximizing, unsigned int depth, std::shared_ptr<Player>& aiPlayer, std::shared_ptr<Player>& opponent, std::shared_ptr<Board>& thisBoard, std::shared_ptr<GameState>& layout, int alpha, int beta);
-        
-        /// Computes the best move using minimax
-        /// @param aiPlayer Reference to the player we're computing the best next move for.
-        /// @param mainGameBoard Reference to the game board we're finding the best next move on.
-        /// @param mainGameState Reference to the board's gamestate.
-        /// @param possibleMoves List of all moves the aiPlayer could make.
-        /// @param depth The depth we want for minimax (how many tree nodes to build).
-        unsigned int bestMoveMinimax(std::shared_ptr<Player>& aiPlayer, std::shared_ptr<Board>& mainGameBoard, std::shared_ptr<GameState>& mainGameState, std::vector<std::shared_ptr<Tile>>& possibleMoves, unsigned int depth);
-        
-        /// Called after a player places a piece on the board, this evaluates their gamestate advantage score.
-        /// @param forWho The player for whom to calculate the gamestate advantage score (after they've placed a new piece).
-        /// @param layout The gamestate from which to calculate the advantage score from.
-        int evalGamestateScore(std::shared_ptr<Player>& forWho, std::shared_ptr<GameState>& layout);
+        int minimax(bool maximizing, unsigned int depth, const Position& pos, Side aiSide, int alpha, int beta);
+        
+        /// Computes the best move with iterative deepening: searches depth 0, 1, 2... until the limits run out,
+        /// and returns the best move of the deepest iteration that finished. Each iteration searches the previous one's best moves first.
+        /// Works on a bare position, so it needs no board or players (the game's GameState::bestMoveMinimax converts its tiles to one).
+        /// @param pos The position to search, with the AI to move (pos.toMove).
+        /// @param rootMoves The moves to choose from (squares); ties go to the one listed first.
+        /// @param limits Depth, time and node budgets for the search.
+        /// @return Index into rootMoves of the best move.
+        unsigned int bestMove(const Position& pos, const std::vector<int>& rootMoves, const SearchLimits& limits);
+        
+        /// Returns how far the search in progress (or the last one) has got. Safe to call while another thread is searching.
+        inline SearchProgress getProgress() const {
+            return SearchProgress{iterationsDone_.load(), progressBestMove_.load(), sharedNodes_.load(std::memory_order_relaxed)};
+        }
+        
+        /// Returns what the last bestMove call did.
+        inline const SearchInfo& getLastSearchInfo() const {
+            return lastSearch_;
+        }
+        
+        /// Chooses whether bestMove also counts leaf evaluations and cutoffs per ply, for SearchInfo (off by default).
+        /// Each thread counts into its own counters, which are only added up when the search ends; nodes and iteration times are always kept.
+        inline void setSearchStats(bool enabled) {
+            searchStats_ = enabled;
+        }
+        
+        inline bool getSearchStats() const {
+            return searchStats_;
+        }
+        
+        /// Evaluates the gamestate advantage score of a bitboard position, with the evaluator chosen by setEvaluator().
+        /// @param pos The position to score.
+        /// @param forWho The side to calculate the advantage score for.
+        int evalPosition(const Position& pos, Side forWho);
+        
+        /// Evaluates many positions at once, each for its own side to move, with the evaluator chosen by setEvaluator().
+        /// With the pattern tables this goes through PatternEvaluator::evaluateBatch, many times faster per position than evalPosition (e.g. for tuning or self-play).
+        /// @param positions The positions to score.
+        /// @param count How many there are.
+        /// @param scores Receives the scores, in the same order.
+        void evalPositions(const Position* positions, size_t count, int* scores);
+        
+        /// Chooses the evaluation the search uses (pattern tables by default).
+        void setEvaluator(Evaluator evaluator);
+        
+        inline Evaluator getEvaluator() const {
+            return evaluator_;
+        }
+        
+        /// Returns the pattern evaluator, e.g. to load trained tables into it.
+        inline PatternEvaluator& getPatternEvaluator() {
+            return patternEval_;
+        }
+        
+        /// Reallocates the transposition table (clearing it).
+        /// @param sizeMB Memory budget for the table in megabytes.
+        /// @param policy How new entries replace old ones when a bucket is full.
+        void configureTranspositionTable(size_t sizeMB, ReplacementPolicy policy);
+        
+        /// Returns the transposition table, e.g. to read its hit-rate statistics.
+        inline TranspositionTable& getTranspositionTable() {
+            return transTable_;
+        }
+        
+        /// Forgets what earlier searches left behind (transposition & endgame tables, killer moves & history), so the next search runs as it
+        /// would on a new AiMind with the same settings, e.g. to time the same search more than once. negamax() & minimax() never do this themselves.
+        void clearSearchState();
+        
+        /// Chooses the move ordering stages (a combination of OrderingStage flags) used by every search thread.
+        void setOrderingStages(unsigned int stages);
+        
+        /// Returns the move ordering cutoff statistics, summed over all threads and searches.
+        inline const OrderingStats& getOrderingStats() const {
+            return orderingStats_;
+        }
+        
+        /// Sets how many threads bestMove searches with (1 = search on the calling thread only).
+        /// Threads share out the root moves and, when those run low, the moves of interior nodes.
+        void setSearchThreads(unsigned int numThreads);
+        
+        inline unsigned int getSearchThreads() const {
+            return (unsigned int)threads_.size();
+        }
+        
+        /// Sets how close to the end of the game bestMove switches to the endgame solver (0 = never).
+        /// @param exactEmpties Positions with at most this many empty squares are solved for the exact final score.
+        /// @param winLossDrawEmpties Positions with at most this many are solved for win, loss or draw (much cheaper than exact).
+        void setEndgameSolve(unsigned int exactEmpties, unsigned int winLossDrawEmpties);
+        
+        /// Sets the opening book bestMove plays from, without searching, while the position is in it (null = no book).
+        void setOpeningBook(std::shared_ptr<const OpeningBook> book);
+        
+        inline const std::shared_ptr<const OpeningBook>& getOpeningBook() const {
+            return openingBook_;
+        }
         
         //disabled constructors & operators
         AiMind(AiMind&& obj) = delete;        // move
@@ -0,0 +1,27 @@
+//
+//  BookBuilder.hpp
+//  Othello
+//
+//  Builds an opening book by searching the opening positions offline, so games only pay for the lookups.
+//
+
+#ifndef BookBuilder_hpp
+#define BookBuilder_hpp
+
+#include "AiMind.hpp"
+#include "OpeningBook.hpp"
+#include <vector>
+#include <ostream>
+
+namespace othello {
+
+    /// Searches every position the AI can meet in the first 'plies' plies of a game, playing either color: the AI follows
+    /// its own book moves, the opponent may play anything. Positions that are rotations or reflections of each other are searched once.
+    /// @param ai The AI to search with (it shouldn't have a book set, or it would just read the old one back).
+    /// @param plies Plies from the start of the game the book covers.
+    /// @param depth Depth every position is searched to.
+    /// @param log If set, progress is written here after each ply.
+    std::vector<BookEntry> buildOpeningBook(AiMind& ai, unsigned int plies, unsigned int depth, std::ostream* log);
+}
+
+#endif /* BookBuilder_hpp */
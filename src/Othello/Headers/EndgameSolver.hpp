@@ -0,0 +1,136 @@
+//
+//  EndgameSolver.hpp
+//  Othello
+//
+//  Perfect play for the last few empty squares. Instead of the heuristic evaluation, positions are searched to the end of the game
+//  and scored by the final disc difference, so the result is exact. Passes are handled properly (the heuristic search doesn't).
+//
+
+#ifndef EndgameSolver_hpp
+#define EndgameSolver_hpp
+
+#include "Position.hpp"
+#include "TranspositionTable.hpp"
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace othello {
+
+    /// What the solver has to find out.
+    enum class SolveMode {
+        /// The exact final disc difference.
+        EXACT,
+        /// Only whether the side to move wins, loses or draws (much faster).
+        WIN_LOSS_DRAW
+    };
+
+    struct EndgameResult {
+        /// Final disc difference for the side to move with perfect play from both sides (empty squares go to the winner).
+        /// With SolveMode::WIN_LOSS_DRAW only the sign is meaningful.
+        int score;
+
+        /// Best move (square) for the side to move.
+        int bestMove;
+
+        /// Positions visited.
+        uint64_t nodes;
+    };
+
+    class EndgameSolver {
+    private:
+        /// Positions with fewer empties than this aren't stored in the table (they're quicker to solve than to look up).
+        static const int MIN_TABLE_EMPTIES_;
+
+        /// Positions with fewer empties than this are solved by the small kernels (no move generation or ordering); there's one kernel per count below it.
+        static const int SMALL_KERNEL_EMPTIES_ = 5;
+
+        /// Positions with fewer empties than this order their moves by parity alone (fastest-first costs more than it saves there).
+        static const int FASTEST_FIRST_EMPTIES_;
+
+        /// Solved positions, keyed like AiMind's table. Scores here are disc differences, so the table is separate.
+        TranspositionTable table_;
+        TTStats tableStats_;
+
+        /// Hash of the position being searched, updated with every move & pass.
+        uint64_t hash_;
+
+        uint64_t nodes_;
+
+        const std::atomic<bool>* stopFlag_;
+        bool hasDeadline_;
+        std::chrono::steady_clock::time_point deadline_;
+
+        /// Set once the stop flag or the deadline is hit; every node then returns straight away.
+        bool stopped_;
+
+        /// Negamax alpha-beta to the end of the game, for the side to move.
+        /// @param pos Position to solve; modified during the search, but restored before returning.
+        /// @param empties Its empty squares.
+        /// @param passed Whether the previous move was a pass (a second pass ends the game).
+        int search_(Position& pos, Bitboard empties, int alpha, int beta, bool passed);
+
+        /// Same as search_, for the last few empties: lists them, odd regions first, and hands them to the kernel for that many.
+        int searchSmall_(Position& pos, Bitboard empties, int alpha, int beta, bool passed);
+
+        /// Score with one empty square left (no search needed).
+        int solveLast1_(const Position& pos, int sq) const;
+
+        /// Kernels for two, three & four empty squares, tried in the order given: the squares are passed directly, so there's no
+        /// move generation, ordering or hashing, and each move's flips are computed once. Same results as search_.
+        int solveLast2_(Position& pos, int sq1, int sq2, int alpha, int beta, bool passed);
+        int solveLast3_(Position& pos, int sq1, int sq2, int sq3, int alpha, int beta, bool passed);
+        int solveLast4_(Position& pos, int sq1, int sq2, int sq3, int sq4, int alpha, int beta, bool passed);
+
+        /// Disc difference for the side to move at the end of the game, empties going to the winner.
+        int finalScore_(const Position& pos) const;
+
+        /// Upper bound on the side to move's final score: the opponent keeps at least their stable discs.
+        int stabilityBound_(const Position& pos) const;
+
+        /// Checks the stop flag and deadline every so often.
+        void countNode_();
+
+        void makeMove_(Position& pos, int sq, MoveUndo& undo);
+        void unmakeMove_(Position& pos, const MoveUndo& undo);
+        void pass_(Position& pos);
+
+    public:
+        /// Creates a solver with a table of roughly 'tableMB' megabytes.
+        EndgameSolver(size_t tableMB);
+
+        //disabled constructors & operators
+        EndgameSolver() = delete;
+        EndgameSolver(const EndgameSolver& obj) = delete;
+        EndgameSolver& operator = (const EndgameSolver& obj) = delete;
+
+        /// Solves 'pos' for the side to move. Returns false (and leaves 'result' alone) if the stop flag or deadline ended the solve first.
+        /// @param pos The position to solve.
+        /// @param rootMoves The moves to choose from (squares, legal for the side to move); ties go to the one listed first.
+        /// @param mode Exact score or just win/loss/draw.
+        /// @param result Set to the solution.
+        bool solve(const Position& pos, const std::vector<int>& rootMoves, SolveMode mode, EndgameResult& result);
+
+        /// Makes solve() give up once this flag becomes true (null = never).
+        inline void setStopFlag(const std::atomic<bool>* stopFlag) {
+            stopFlag_ = stopFlag;
+        }
+
+        /// Makes solve() give up at 'deadline'.
+        inline void setDeadline(std::chrono::steady_clock::time_point deadline) {
+            hasDeadline_ = true;
+            deadline_ = deadline;
+        }
+
+        inline void clearDeadline() {
+            hasDeadline_ = false;
+        }
+
+        /// Forgets the positions earlier solves stored.
+        inline void clearTable() {
+            table_.clear();
+        }
+    };
+}
+
+#endif /* EndgameSolver_hpp */
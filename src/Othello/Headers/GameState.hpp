@@ -14,6 +14,8 @@
 #include <memory>
 #include "Board.hpp"
 #include "Player.hpp"
+#include "Position.hpp"
+#include "AiMind.hpp"
 
 
 namespace othello {
@@ -32,6 +34,15 @@ namespace othello {
         std::shared_ptr<Player> playerBlack_;
         std::shared_ptr<Player> playerWhite_;
         
+        /// Bitboard copy of the discs on board_. All rule checks run on this; board_'s Tiles are only kept in sync for rendering.
+        Position position_;
+        
+        /// Shared implementation of both placePiece overloads. Updates position_, then board_'s tiles & disc animations.
+        /// @param forWho Reference to the player who should own the new piece.
+        /// @param on Reference to the tile to place the new piece on.
+        /// @param newDisc Set to the new Disc that was placed.
+        unsigned int placePiece_(std::shared_ptr<Player>& forWho, std::shared_ptr<Tile>& on, std::shared_ptr<Disc>& newDisc);
+        
     public:
         /// Constructs a new GameState object, which stores references player objects & board object.
         /// Creating new GameState objects other than the main one (the one that's rendered in the game window) is done when an AI needs to hypothesize different possible moves that it can take.
@@ -62,7 +73,7 @@ namespace othello {
         /// @param curPlayer the player whose placing a piece (whose turn it is)
         bool tileIsFlanked(std::shared_ptr<Tile>& tile, std::shared_ptr<Player>& curPlayer);
      
-        /// Given a tile with a disc on it, returns whether that disc can be flipped (currently) by the opponent of 'curPlayer'.
+        /// Given a tile with a disc on it, returns whether that disc can never be flipped (see stableDiscs).
         /// @param tile Reference to the Tile to check stability for.
         bool discIsStable(std::shared_ptr<Tile>& tile);
         
@@ -112,6 +123,30 @@ namespace othello {
             return board_->getBoardTile(at);
         }
         
+        /// Returns which side (black or white) the given player plays.
+        /// @param who The player to look up.
+        Side sideOf(std::shared_ptr<Player>& who);
+        
+        /// Computes the best move with 'mind' (see AiMind::bestMove), from this gamestate's position.
+        /// @param mind The AI to search with.
+        /// @param aiPlayer Reference to the player we're computing the best next move for.
+        /// @param possibleMoves List of all moves the aiPlayer could make.
+        /// @param limits Depth, time and node budgets for the search.
+        /// @return Index into possibleMoves of the best move.
+        unsigned int bestMoveMinimax(AiMind& mind, std::shared_ptr<Player>& aiPlayer, std::vector<std::shared_ptr<Tile>>& possibleMoves, const SearchLimits& limits);
+        /// @param depth The depth we want for minimax (how many tree nodes to build), with no time or node limit.
+        unsigned int bestMoveMinimax(AiMind& mind, std::shared_ptr<Player>& aiPlayer, std::vector<std::shared_ptr<Tile>>& possibleMoves, unsigned int depth);
+        
+        /// Called after a player places a piece on the board, this evaluates their gamestate advantage score with 'mind''s evaluation.
+        /// @param mind The AI whose evaluation to use.
+        /// @param forWho The player for whom to calculate the gamestate advantage score (after they've placed a new piece).
+        int evalGamestateScore(AiMind& mind, std::shared_ptr<Player>& forWho);
+        
+        /// Returns the bitboard position the rules & AI run on.
+        inline const Position& getPosition() const {
+            return position_;
+        }
+        
         /// Return a reference to this gamestate's game board (vector of all tiles).
         inline std::shared_ptr<Board> getBoard() {
             return board_;
@@ -0,0 +1,143 @@
+//
+//  MoveOrdering.hpp
+//  Othello
+//
+//  Decides which order minimax tries moves in. Alpha-beta prunes the most when the best move is searched first,
+//  so each node's moves are scored by a set of stages (hash move, killers, history, square priority, opponent mobility) and tried best-first.
+//  Also keeps cutoff statistics so the ordering quality can be measured.
+//
+
+#ifndef MoveOrdering_hpp
+#define MoveOrdering_hpp
+
+#include <cstdint>
+#include "Position.hpp"
+
+namespace othello {
+
+    /// Ordering stages, combined as bit flags in MoveOrderer::setStages().
+    enum OrderingStage : unsigned int {
+        /// The best move stored in the transposition table for this position.
+        ORDER_HASH_MOVE = 1 << 0,
+        /// Moves that caused a cutoff at the same ply elsewhere in the tree.
+        ORDER_KILLERS = 1 << 1,
+        /// Moves that have caused cutoffs anywhere, weighted by depth.
+        ORDER_HISTORY = 1 << 2,
+        /// Fixed square values: corners first, X-squares last.
+        ORDER_SQUARE_PRIORITY = 1 << 3,
+        /// Moves that leave the opponent the fewest replies.
+        ORDER_OPPONENT_MOBILITY = 1 << 4,
+
+        ORDER_ALL = (1 << 5) - 1
+    };
+
+    /// A move and the priority the ordering gave it.
+    struct ScoredMove {
+        int square;
+        int score;
+    };
+
+    /// Counts used to judge how good the ordering is. Reset with resetStats().
+    struct OrderingStats {
+        /// Nodes whose moves were ordered.
+        uint64_t nodes;
+        /// Nodes where a move caused a beta cutoff.
+        uint64_t cutoffs;
+        /// Cutoffs caused by the first move tried.
+        uint64_t firstMoveCutoffs;
+        /// Sum of the (0-based) position of the cutoff move, over all cutoffs.
+        uint64_t cutoffIndexSum;
+
+        /// Fraction of cutoffs that happened on the first move (1.0 = perfect ordering).
+        inline double firstMoveCutoffRate() const {
+            return cutoffs ? (double)firstMoveCutoffs / cutoffs : 0.0;
+        }
+
+        /// How many moves were tried before the cutoff move, on average.
+        inline double averageCutoffIndex() const {
+            return cutoffs ? (double)cutoffIndexSum / cutoffs : 0.0;
+        }
+
+        inline OrderingStats& operator += (const OrderingStats& other) {
+            nodes += other.nodes;
+            cutoffs += other.cutoffs;
+            firstMoveCutoffs += other.firstMoveCutoffs;
+            cutoffIndexSum += other.cutoffIndexSum;
+            return *this;
+        }
+    };
+
+    class MoveOrderer {
+    private:
+        /// Deepest ply killer moves are kept for.
+        static const unsigned int MAX_PLY_ = NUM_SQUARES;
+
+        /// Opponent mobility needs every move to be played out, so it's only worth it this far from the leaves.
+        static const unsigned int OPPONENT_MOBILITY_MIN_DEPTH_;
+
+        /// Static square priorities, indexed by square.
+        static const int SQUARE_PRIORITY_[NUM_SQUARES];
+
+        /// Which OrderingStage flags are enabled.
+        unsigned int stages_;
+
+        /// Two most recent cutoff moves per ply (NO_SQUARE if none).
+        int killers_[MAX_PLY_][2];
+
+        /// Cutoff history per side & square.
+        int history_[2][NUM_SQUARES];
+
+        OrderingStats stats_;
+
+    public:
+        /// Creates an orderer with all stages enabled.
+        MoveOrderer();
+
+        //disabled constructors & operators
+        MoveOrderer(const MoveOrderer& obj) = delete;
+        MoveOrderer& operator = (const MoveOrderer& obj) = delete;
+
+        /// Chooses which stages are used (a combination of OrderingStage flags).
+        inline void setStages(unsigned int stages) {
+            stages_ = stages;
+        }
+
+        inline unsigned int getStages() const {
+            return stages_;
+        }
+
+        /// Starts a new search: forgets killer moves and fades the history so it favours recent searches.
+        void newSearch();
+
+        /// Forgets killer moves and history altogether, as if the orderer was new (its stages & statistics are kept).
+        void clear();
+
+        /// Scores 'moves' and writes them into 'out', best first. Returns the number of moves written.
+        /// @param pos The position being searched.
+        /// @param mover The side whose moves these are.
+        /// @param moves The legal moves to order.
+        /// @param hashMove The transposition table's best move for this position, or NO_SQUARE.
+        /// @param ply Distance from the root.
+        /// @param depth Remaining search depth.
+        /// @param out Array with room for every legal move (NUM_SQUARES is always enough).
+        unsigned int orderMoves(const Position& pos, Side mover, Bitboard moves, int hashMove, unsigned int ply, unsigned int depth, ScoredMove* out);
+
+        /// Called when the move at position 'moveIndex' of the ordered list caused a beta cutoff.
+        /// @param mover The side that played the move.
+        /// @param sq The cutoff move.
+        /// @param ply Distance from the root.
+        /// @param depth Remaining search depth.
+        /// @param moveIndex Where the move was in the ordered list.
+        void recordCutoff(Side mover, int sq, unsigned int ply, unsigned int depth, unsigned int moveIndex);
+
+        inline const OrderingStats& getStats() const {
+            return stats_;
+        }
+
+        inline void resetStats() {
+            stats_ = OrderingStats{};
+        }
+    };
+}
+
+#endif /* MoveOrdering_hpp */
@@ -0,0 +1,123 @@
+//
+//  OpeningBook.hpp
+//  Othello
+//
+//  Precomputed best moves for opening positions, so the AI's first moves need no search.
+//  The book is a binary file laid out exactly as it is used: a header followed by an open-addressing hash table of entries.
+//  It is memory-mapped read-only, so loading it parses nothing, and a lookup is a hash plus a probe or two.
+//  Positions are keyed by their canonical hash (the smallest hash over the board's 8 symmetries), so one entry covers
+//  every rotation & reflection of a position.
+//
+
+#ifndef OpeningBook_hpp
+#define OpeningBook_hpp
+
+#include "Position.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace othello {
+
+    /// Start of a book file.
+    struct BookHeader {
+        /// BOOK_MAGIC, so other files aren't mistaken for books.
+        char magic[8];
+
+        /// BOOK_VERSION the file was written with.
+        uint32_t version;
+
+        /// sizeof(BookEntry) when the file was written (catches files from a build with a different layout or endianness).
+        uint32_t entrySize;
+
+        /// Slots in the table that follows the header (a power of two).
+        uint64_t numSlots;
+
+        /// Slots in use.
+        uint64_t numEntries;
+    };
+
+    /// One slot of a book's table.
+    struct BookEntry {
+        /// Canonical hash of the position (see OpeningBook::canonicalKey). 0 marks an empty slot.
+        uint64_t key;
+
+        /// Score the search gave the move, for the side to move.
+        int16_t score;
+
+        /// Best move (square), in the orientation of the canonical position.
+        uint8_t move;
+
+        /// Depth the move was searched to.
+        uint8_t depth;
+
+        uint32_t reserved;
+    };
+
+    /// A move found in the book.
+    struct BookMove {
+        /// Square to play, in the orientation of the position looked up.
+        int square;
+        int score;
+        unsigned int depth;
+    };
+
+    class OpeningBook {
+    private:
+        /// The whole file (mapped, or read into buffer_ where mapping isn't available).
+        const unsigned char* data_;
+        size_t size_;
+
+        const BookHeader* header_;
+        const BookEntry* entries_;
+
+#ifdef _WIN32
+        std::vector<unsigned char> buffer_;
+#endif
+
+    public:
+        /// Creates an empty book (every lookup misses) until open() succeeds.
+        OpeningBook();
+
+        /// Unmaps the file.
+        ~OpeningBook();
+
+        //disabled constructors & operators
+        OpeningBook(const OpeningBook& obj) = delete;
+        OpeningBook& operator = (const OpeningBook& obj) = delete;
+
+        /// Maps the book file at 'path', replacing any book already open. Returns false (leaving the book empty) if the file
+        /// is missing or isn't a valid book.
+        bool open(const std::string& path);
+
+        /// Unmaps the file, leaving the book empty.
+        void close();
+
+        inline bool isOpen() const {
+            return header_ != nullptr;
+        }
+
+        /// Number of positions in the book.
+        inline size_t size() const {
+            return header_ ? (size_t)header_->numEntries : 0;
+        }
+
+        /// Looks up the book move for the side to move. Returns false if the position isn't in the book.
+        bool lookup(const Position& pos, BookMove& out) const;
+
+        /// Hash of the position's canonical form: the smallest hash over the 8 rotations & reflections of the board.
+        /// @param symmetry Set to the symmetry (see transformSquare) that turns 'pos' into its canonical form.
+        static uint64_t canonicalKey(const Position& pos, int& symmetry);
+
+        /// Where square 'sq' ends up under symmetry 'symmetry' (0-7: bit 2 transposes the board, then bit 0 mirrors x and bit 1 mirrors y).
+        static int transformSquare(int sq, int symmetry);
+
+        /// Applies symmetry 'symmetry' (see transformSquare) to every square of 'b'.
+        static Bitboard transformBitboard(Bitboard b, int symmetry);
+
+        /// Writes a book file holding 'entries' (their keys must be distinct and non-zero). Returns false if the file can't be written.
+        static bool write(const std::string& path, const std::vector<BookEntry>& entries);
+    };
+}
+
+#endif /* OpeningBook_hpp */
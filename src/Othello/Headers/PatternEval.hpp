@@ -0,0 +1,140 @@
+//
+//  PatternEval.hpp
+//  Othello
+//
+//  Evaluation by pattern tables: the board is cut into lines and corner regions (edges, diagonals, 3x3 and 2x5 corners),
+//  each one's contents are read as a base-3 number (empty / mine / theirs), and that number indexes a table of precomputed scores.
+//  A leaf then costs a few dozen table lookups plus a couple of popcounts, instead of working out each feature square by square.
+//  Every table comes in one copy per game phase, so the same shape can be worth different amounts in the opening and the endgame.
+//
+
+#ifndef PatternEval_hpp
+#define PatternEval_hpp
+
+#include "Position.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace othello {
+
+    /// Shapes of board region the evaluation scores. Every rotation & reflection of a shape shares its table.
+    enum PatternType : unsigned int {
+        /// A whole edge plus the two X-squares next to it (10 squares).
+        PATTERN_EDGE_2X,
+        /// The 3x3 block in a corner (9 squares).
+        PATTERN_CORNER_3X3,
+        /// A 2x5 block along an edge, starting in a corner (10 squares).
+        PATTERN_CORNER_2X5,
+        /// Diagonals of 8 down to 4 squares.
+        PATTERN_DIAG_8,
+        PATTERN_DIAG_7,
+        PATTERN_DIAG_6,
+        PATTERN_DIAG_5,
+        PATTERN_DIAG_4,
+
+        NUM_PATTERN_TYPES
+    };
+
+    /// Places the pattern types sit on the board: 4 edges, 4 + 8 corner blocks, 2 long diagonals and 4 of each shorter length.
+    const unsigned int NUM_PATTERN_INSTANCES = 34;
+
+    /// The pattern indices of a position, kept up to date move by move (see PatternEvaluator::applyMove) so a leaf doesn't have to work them out
+    /// square by square. The bitboard features (disc counts, mobility, frontier & stability) are still worked out at the leaf (see evaluate()).
+    struct EvalState {
+        /// For each pattern instance and side, the sum of 3^(digit position) over the instance's squares holding that side's discs.
+        /// The index seen by side s is then discs[s] + 2 * discs[opponent].
+        uint32_t discs[2][NUM_PATTERN_INSTANCES];
+    };
+
+    /// Number of game phases the tables are split into (by number of empty squares).
+    const unsigned int NUM_EVAL_PHASES = 4;
+
+    /// Weights of the features that aren't patterns, for one phase.
+    struct PhaseWeights {
+        /// Per disc of difference between the two sides.
+        int16_t disc;
+        /// Per legal move of difference.
+        int16_t mobility;
+        /// Per frontier disc (next to an empty square) of difference.
+        int16_t frontier;
+        /// Per stable disc off the edges of difference (the edge tables already score stability along the edges).
+        int16_t stability;
+    };
+
+    /// Code paths PatternEvaluator::evaluateBatch() can take, narrowest first.
+    enum class BatchPath {
+        /// evaluate() on one position after another (any CPU).
+        SCALAR,
+        /// 8 positions at a time in AVX2 registers (x86-64).
+        AVX2,
+        /// 16 positions at a time in AVX-512 registers (x86-64).
+        AVX512
+    };
+
+    /// Name of a batch code path, for logs.
+    const char* batchPathName(BatchPath path);
+
+    class PatternEvaluator {
+    private:
+        /// All tables of all phases, one phase after another (each phase's tables in PatternType order).
+        std::vector<int16_t> tables_;
+
+        PhaseWeights phaseWeights_[NUM_EVAL_PHASES];
+
+        /// Fills the tables & weights from the hand-tuned weights (see the constructor).
+        void seed_(int discWeight, int mobilityWeight, int stabilityWeight, int cornerWeight, int cornerAdjWeight, int frontierWeight);
+
+    public:
+        /// Creates tables that score the same features as the hand-tuned evaluation, for both sides:
+        /// corners, corner-adjacent squares while their corner is empty, discs the edge patterns show to be stable along their edge,
+        /// and (outside the tables) discs, mobility, frontier discs and stable discs off the edges. These are the same in every phase until trained tables are loaded.
+        PatternEvaluator(int discWeight, int mobilityWeight, int stabilityWeight, int cornerWeight, int cornerAdjWeight, int frontierWeight);
+
+        //disabled constructors & operators
+        PatternEvaluator() = delete;
+        PatternEvaluator(const PatternEvaluator& obj) = delete;
+        PatternEvaluator& operator = (const PatternEvaluator& obj) = delete;
+
+        /// Scores 'pos' for 'forWho' (positive = good for them, and the opponent gets exactly the negated score).
+        int evaluate(const Position& pos, Side forWho) const;
+
+        /// Same as evaluate(), reading the pattern indices from 'state' (which must match 'pos') instead of the board.
+        int evaluate(const Position& pos, const EvalState& state, Side forWho) const;
+
+        /// Scores 'count' positions, each for its own side to move: scores[i] = evaluate(positions[i], positions[i].toMove).
+        /// On CPUs with AVX2 or AVX-512 a block of positions is worked on side by side in vector registers (pattern indices, mobility and frontier
+        /// for every lane at once, then one gather instruction per pattern instance for the table lookups), which costs a fraction of evaluate() per position.
+        void evaluateBatch(const Position* positions, size_t count, int* scores) const;
+
+        /// Same, on a given code path (e.g. to compare them). Falls back to bestBatchPath() if the CPU can't run 'path'.
+        void evaluateBatch(const Position* positions, size_t count, int* scores, BatchPath path) const;
+
+        /// Widest batch code path the CPU running this supports (checked once, at the first call).
+        static BatchPath bestBatchPath();
+
+        /// Works out the pattern indices of 'pos' from scratch.
+        static void initState(const Position& pos, EvalState& state);
+
+        /// Updates 'state' for a move made with Position::makeMove: only the instances covering the new disc & the flipped ones change.
+        static void applyMove(EvalState& state, const MoveUndo& move);
+
+        /// Takes back applyMove().
+        static void undoMove(EvalState& state, const MoveUndo& move);
+
+        /// Phase (0 to NUM_EVAL_PHASES - 1) of a position with 'empties' empty squares.
+        static inline unsigned int phaseOf(int empties) {
+            return (unsigned int)((60 - empties) * (int)NUM_EVAL_PHASES / 61);
+        }
+
+        /// Replaces the tables & weights with ones from a file written by save() (e.g. after training them on game records).
+        /// Returns false, leaving the current ones, if the file is missing or doesn't match this build's pattern set.
+        bool load(const std::string& path);
+
+        /// Writes the tables & weights to a file load() can read. Returns false if it can't be written.
+        bool save(const std::string& path) const;
+    };
+}
+
+#endif /* PatternEval_hpp */
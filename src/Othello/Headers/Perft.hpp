@@ -0,0 +1,54 @@
+//
+//  Perft.hpp
+//  Othello
+//
+//  Perft: counts the positions a given number of plies below a position, to check move generation & move making against
+//  known counts, and to time them. Turns go as in the game loop: a side with no legal move passes (a ply of its own),
+//  and when neither side can move the game is over, which counts as one leaf however many plies were left.
+//
+
+#ifndef Perft_hpp
+#define Perft_hpp
+
+#include "Position.hpp"
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace othello {
+
+    /// Published leaf counts from the initial position, indexed by depth (depth 0 is the position itself).
+    const std::vector<uint64_t>& perftReferenceCounts();
+
+    /// Number of leaves 'depth' plies below 'pos', on the calling thread.
+    /// @param bulk Count the moves of the last ply from the legal move mask instead of making each of them.
+    uint64_t perft(const Position& pos, unsigned int depth, bool bulk);
+
+    /// Leaf count of each move of the side to move (in ascending square order), each searched to depth - 1: shows which subtree
+    /// a wrong count is in. A pass is listed as NO_SQUARE.
+    std::vector<std::pair<int, uint64_t>> perftDivide(const Position& pos, unsigned int depth, bool bulk);
+
+    /// What one perft run counted and how fast.
+    struct PerftResult {
+        unsigned int depth;
+
+        uint64_t leaves;
+
+        /// Wall-clock time of the count.
+        double seconds;
+
+        /// Leaves counted per second.
+        double leavesPerSecond;
+    };
+
+    /// Same count as perft(), with the subtrees a few plies down shared out among 'numThreads' threads (1 = the calling thread only).
+    PerftResult runPerft(const Position& pos, unsigned int depth, unsigned int numThreads, bool bulk);
+
+    /// Counts from the initial position at every depth up to 'maxDepth' (capped at the deepest reference count), with and without
+    /// bulk counting, and compares them with perftReferenceCounts(). Returns true if every count matched.
+    /// @param log If set, a line is written here for each count.
+    bool validatePerft(unsigned int maxDepth, unsigned int numThreads, std::ostream* log);
+}
+
+#endif /* Perft_hpp */
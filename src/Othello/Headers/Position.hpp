@@ -0,0 +1,222 @@
+//
+//  Position.hpp
+//  Othello
+//
+//  Compact bitboard representation of an Othello position: one 64-bit occupancy mask per player plus the side to move.
+//  All rules (move generation, flips, disc counting) are done with shifts and masks, so the AI never touches Board/Tile objects.
+//
+
+#ifndef Position_hpp
+#define Position_hpp
+
+#include <cstdint>
+#include <string>
+#include "commonTypes.h"
+#include "Topology.hpp"
+
+namespace othello {
+
+    /// The two colors that can own discs (used to index Position::discs).
+    enum Side : unsigned char {
+        SIDE_BLACK = 0,
+        SIDE_WHITE = 1
+    };
+
+    /// Returns the other side.
+    constexpr Side opponentOf(Side side) {
+        return (Side)(side ^ 1);
+    }
+
+    /// Marker for "no square" (e.g. a pass move).
+    const int NO_SQUARE = -1;
+
+    /// Converts a board TilePoint (1-8 in both coords) into a square index (0-63).
+    inline int squareOf(const TilePoint& at) {
+        return (at.y - 1) * 8 + (at.x - 1);
+    }
+
+    /// Converts a square index (0-63) back into a board TilePoint.
+    inline TilePoint tileOf(int sq) {
+        return TilePoint{(sq & 7) + 1, (sq >> 3) + 1};
+    }
+
+    /// Name of a square: its column letter (a-h for x = 1-8) then its row number (y), e.g. "d3" is TilePoint{4, 3}.
+    std::string squareName(int sq);
+
+    /// Reads a square name written by squareName (either case). Returns false if 'name' isn't one.
+    bool parseSquare(const std::string& name, int& sq);
+
+    /// Number of set bits.
+    inline int popCount(Bitboard b) {
+        return __builtin_popcountll(b);
+    }
+
+    /// Index of the lowest set bit (b must not be 0).
+    inline int lowestSquare(Bitboard b) {
+        return __builtin_ctzll(b);
+    }
+
+    /// Removes and returns the lowest set bit's square index (b must not be 0).
+    inline int popLowestSquare(Bitboard& b) {
+        int sq = __builtin_ctzll(b);
+        b &= b - 1;
+        return sq;
+    }
+
+    /// Ways of generating legal moves, narrowest first. All 8 directions are grown Kogge-Stone style (a run's reach doubles each step);
+    /// the vector paths work on several directions at once in the lanes of a register.
+    enum class MoveGenPath {
+        /// One direction after another (any CPU).
+        SCALAR,
+        /// 2 directions per register (x86-64).
+        SSE2,
+        /// 4 directions per register (x86-64 with AVX2).
+        AVX2
+    };
+
+    /// Widest move generation path the CPU running this supports (from CPUID). Position::legalMoves picks it the first time it's called.
+    MoveGenPath bestMoveGenPath();
+
+    /// Name of a move generation path, for logs.
+    const char* moveGenPathName(MoveGenPath path);
+
+    /// Legal moves of 'mine' against 'theirs' on a given path (e.g. to compare them). Falls back to bestMoveGenPath() if the CPU can't run 'path'.
+    Bitboard legalMovesOn(MoveGenPath path, Bitboard mine, Bitboard theirs);
+
+    /// Everything needed to take back a move made with Position::makeMove.
+    struct MoveUndo {
+        /// Square the disc was placed on.
+        int square;
+        
+        /// Opponent discs the move flipped.
+        Bitboard flipped;
+        
+        /// Side that made the move.
+        Side mover;
+    };
+
+    struct Position {
+        /// Discs owned by each side, indexed by Side.
+        Bitboard discs[2];
+
+        /// Whose turn it is.
+        Side toMove;
+
+        /// Returns an empty board with black to move.
+        static Position empty();
+
+        /// Returns the standard four-disc starting position with black to move.
+        static Position initial();
+
+        /// The position as text: one character per square in square order ('X' black, 'O' white, '-' empty),
+        /// then a space and the side to move ('X' or 'O').
+        std::string toText() const;
+
+        /// Reads a position written by toText. '.' also counts as empty, whitespace between squares is skipped,
+        /// and black is to move if the side is left out. Returns false, leaving 'pos' unchanged, if 'text' isn't a position.
+        static bool fromText(const std::string& text, Position& pos);
+
+        /// Squares with no disc on them.
+        inline Bitboard emptySquares() const {
+            return ~(discs[SIDE_BLACK] | discs[SIDE_WHITE]);
+        }
+
+        /// Number of discs the given side controls.
+        inline int count(Side who) const {
+            return popCount(discs[who]);
+        }
+
+        /// Number of squares with no disc on them.
+        inline int numEmpties() const {
+            return NUM_SQUARES - popCount(discs[SIDE_BLACK] | discs[SIDE_WHITE]);
+        }
+
+        /// Returns which side owns the square, writing it into 'owner'. Returns false if the square is empty.
+        inline bool ownerOf(int sq, Side& owner) const {
+            if (discs[SIDE_BLACK] & squareBit(sq)) {
+                owner = SIDE_BLACK;
+                return true;
+            }
+            if (discs[SIDE_WHITE] & squareBit(sq)) {
+                owner = SIDE_WHITE;
+                return true;
+            }
+            return false;
+        }
+
+        /// All empty squares where 'who' can legally place a disc.
+        Bitboard legalMoves(Side who) const;
+
+        /// Legal moves for the side to move.
+        inline Bitboard legalMoves() const {
+            return legalMoves(toMove);
+        }
+
+        /// Opponent discs that would be flipped if 'who' placed a disc on 'sq' (0 if the placement flanks nothing).
+        /// Looked up in precomputed tables, two per line through 'sq', so a move costs the same however many discs it flips.
+        Bitboard flips(Side who, int sq) const;
+
+        /// Opponent discs flipped in a single direction (see shiftDir for the direction order).
+        Bitboard flipsInDirection(Side who, int sq, int dir) const;
+
+        /// Discs of 'victim' that their opponent could flip with one of their currently legal moves.
+        Bitboard flippableDiscs(Side victim) const;
+
+        /// Places a disc for the side to move on 'sq', flips the flanked discs and passes the turn. Returns the flipped discs.
+        Bitboard play(int sq);
+
+        /// Same as play(), but returns the record unmakeMove() needs to restore this position in place.
+        inline MoveUndo makeMove(int sq) {
+            Side mover = toMove;
+            return MoveUndo{sq, play(sq), mover};
+        }
+        
+        /// Takes back a move made with makeMove(). Moves must be unmade in the reverse order they were made.
+        inline void unmakeMove(const MoveUndo& undo) {
+            discs[undo.mover] &= ~(undo.flipped | squareBit(undo.square));
+            discs[opponentOf(undo.mover)] |= undo.flipped;
+            toMove = undo.mover;
+        }
+        
+        /// Same as makeMove(), for a side to move known at compile time (MOVER must be toMove): the disc sets are picked without looking at toMove.
+        template <Side MOVER>
+        inline MoveUndo makeMoveAs(int sq) {
+            Bitboard flipped = flips(MOVER, sq);
+            discs[MOVER] |= flipped | squareBit(sq);
+            discs[opponentOf(MOVER)] &= ~flipped;
+            toMove = opponentOf(MOVER);
+            return MoveUndo{sq, flipped, MOVER};
+        }
+        
+        /// Takes back a move MOVER made with makeMoveAs().
+        template <Side MOVER>
+        inline void unmakeMoveAs(const MoveUndo& undo) {
+            discs[MOVER] &= ~(undo.flipped | squareBit(undo.square));
+            discs[opponentOf(MOVER)] |= undo.flipped;
+            toMove = MOVER;
+        }
+        
+        /// Passes the turn without placing a disc.
+        inline void pass() {
+            toMove = opponentOf(toMove);
+        }
+
+        /// Adds a disc for 'who' without flipping anything (used for setting up positions).
+        inline void addDisc(Side who, int sq) {
+            discs[opponentOf(who)] &= ~squareBit(sq);
+            discs[who] |= squareBit(sq);
+        }
+
+        /// Neither side has a legal move.
+        inline bool isGameOver() const {
+            return (legalMoves(SIDE_BLACK) | legalMoves(SIDE_WHITE)) == 0;
+        }
+
+        /// Same discs and same side to move.
+        inline bool operator == (const Position& other) const {
+            return (discs[SIDE_BLACK] == other.discs[SIDE_BLACK]) && (discs[SIDE_WHITE] == other.discs[SIDE_WHITE]) && (toMove == other.toMove);
+        }
+    };
+}
+
+#endif /* Position_hpp */
@@ -0,0 +1,66 @@
+//
+//  Profiler.hpp
+//  Othello
+//
+//  Scoped-zone profiler: PROFILE_ZONE("name") records when the enclosing scope starts and how long it lasts, into a ring
+//  buffer owned by the calling thread (no locks while recording), and profiler::writeChromeTrace dumps what's recorded as
+//  Chrome trace JSON (chrome://tracing or ui.perfetto.dev), all threads on one timeline.
+//  Only compiled in when OTHELLO_PROFILE is defined; otherwise the macros expand to nothing and no events are ever recorded.
+//
+
+#ifndef Profiler_hpp
+#define Profiler_hpp
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace othello {
+namespace profiler {
+
+    /// Whether the zones were compiled in (OTHELLO_PROFILE defined).
+    bool enabled();
+
+    /// Names the calling thread in the trace (unnamed threads show up as "thread N").
+    void setThreadName(const std::string& name);
+
+    /// Writes every zone still in the threads' buffers as Chrome trace JSON ("complete" events, in microseconds since the program started).
+    /// Safe to call while other threads record, though zones recorded meanwhile may or may not be in the dump.
+    void writeChromeTrace(std::ostream& out);
+
+    /// Same, to a file. Returns false if it can't be written.
+    bool writeChromeTrace(const std::string& path);
+
+    /// Records one zone on the calling thread from its constructor to its destructor (use PROFILE_ZONE).
+    class Zone {
+    private:
+        const char* name_;
+        int64_t startNs_;
+
+    public:
+        /// @param name A string literal (only the pointer is kept).
+        explicit Zone(const char* name);
+        ~Zone();
+
+        Zone(const Zone& obj) = delete;
+        Zone& operator = (const Zone& obj) = delete;
+    };
+}
+}
+
+#ifdef OTHELLO_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+/// Profiles the rest of the enclosing scope as a zone called 'name' (a string literal).
+#define PROFILE_ZONE(name) othello::profiler::Zone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+/// Profiles the rest of the enclosing function, named after it.
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+/// Names the calling thread in the trace.
+#define PROFILE_THREAD(name) othello::profiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD(name)
+#endif
+
+#endif /* Profiler_hpp */
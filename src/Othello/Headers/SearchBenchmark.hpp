@@ -0,0 +1,66 @@
+//
+//  SearchBenchmark.hpp
+//  Othello
+//
+//  Measures how the AI's search scales with threads: a fixed set of positions is searched to a fixed depth
+//  with each thread count, and the times are compared with the single-threaded time.
+//  Also measures the evaluation's throughput, one position at a time against the batch code paths.
+//
+
+#ifndef SearchBenchmark_hpp
+#define SearchBenchmark_hpp
+
+#include "AiMind.hpp"
+#include <vector>
+#include <ostream>
+#include <string>
+
+namespace othello {
+
+    /// One thread count's results over the whole position set.
+    struct ThreadBenchmarkResult {
+        unsigned int threads;
+        /// Wall-clock time to search every position to the benchmark depth.
+        double seconds;
+        uint64_t nodes;
+        /// Time with the first thread count tried, divided by this one's time.
+        double speedup;
+        /// Positions where this thread count chose a different move or score than the first one tried (see AiMind::searchRoot_).
+        size_t mismatches;
+    };
+
+    /// One way of evaluating positions, and how fast it went.
+    struct EvalBenchmarkResult {
+        /// "single" for PatternEvaluator::evaluate on each position, else the batch code path's name.
+        std::string method;
+        double positionsPerSecond;
+        /// Positions per second divided by the single-position rate.
+        double speedup;
+        /// Positions whose score differed from the single-position one (should always be 0).
+        size_t mismatches;
+    };
+
+    /// The fixed positions the benchmarks search: openings through late midgames, reached from the initial position by a fixed move sequence.
+    /// Every position has the side to move able to move.
+    std::vector<Position> benchmarkPositions();
+
+    /// Searches every benchmark position to 'depth' with each of 'threadCounts', starting each thread count as cold as a new AI
+    /// (transposition & endgame tables, killer moves & history cleared with AiMind::clearSearchState), and compares each thread count's moves & scores
+    /// with the first one's. The AI's thread count is left at the last one tried.
+    /// @param ai The AI to benchmark.
+    /// @param depth Iterative deepening depth to reach on every position.
+    /// @param threadCounts Thread counts to try; speedups are relative to the first.
+    /// @param log If set, a line is written here as each thread count finishes.
+    std::vector<ThreadBenchmarkResult> runThreadBenchmark(AiMind& ai, unsigned int depth, const std::vector<unsigned int>& threadCounts, std::ostream* log);
+
+    /// Every position met in fixed pseudo-random games from the initial position, 'count' of them.
+    std::vector<Position> evalBenchmarkPositions(size_t count);
+
+    /// Evaluates 'numPositions' positions one at a time, then with each batch code path the CPU supports, and compares the rates.
+    /// @param eval The evaluator to benchmark.
+    /// @param numPositions How many positions to evaluate each way.
+    /// @param log If set, a line is written here for each way.
+    std::vector<EvalBenchmarkResult> runEvalBenchmark(const PatternEvaluator& eval, size_t numPositions, std::ostream* log);
+}
+
+#endif /* SearchBenchmark_hpp */
@@ -0,0 +1,88 @@
+//
+//  SearchJob.hpp
+//  Othello
+//
+//  Runs one AiMind search on a worker thread, so the caller (the GLUT timer) stays free to draw, animate and take input.
+//  The caller starts the job, polls it once per frame, and can cancel it at any time.
+//
+
+#ifndef SearchJob_hpp
+#define SearchJob_hpp
+
+#include "AiMind.hpp"
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <chrono>
+
+namespace othello {
+
+    class SearchJob {
+    private:
+        std::shared_ptr<AiMind> mind_;
+
+        std::thread worker_;
+
+        /// Handed to the search through SearchLimits::stopFlag; set by cancel().
+        std::atomic<bool> stopFlag_;
+
+        /// Set by the worker once the search has returned.
+        std::atomic<bool> finished_;
+
+        /// Index of the chosen move, valid once finished_ is set.
+        unsigned int result_;
+
+        /// When start() was called.
+        std::chrono::steady_clock::time_point startTime_;
+
+        /// Started, and the result not collected yet.
+        bool running_;
+
+    public:
+        /// Creates an idle job that searches with 'mind'. The mind must not be used by anyone else while the job is running.
+        SearchJob(std::shared_ptr<AiMind> mind);
+
+        /// Cancels a running search.
+        ~SearchJob();
+
+        //disabled constructors & operators
+        SearchJob() = delete;
+        SearchJob(const SearchJob& obj) = delete;
+        SearchJob& operator = (const SearchJob& obj) = delete;
+
+        /// Starts searching on the worker thread (see AiMind::bestMove). The job must not be running.
+        /// @param pos The position to search, with the AI to move.
+        /// @param rootMoves The moves to choose from.
+        /// @param limits Depth, time and node budgets for the search.
+        void start(const Position& pos, const std::vector<int>& rootMoves, const SearchLimits& limits);
+
+        /// True from start() until the result is collected by poll() or the search is cancelled.
+        inline bool isRunning() const {
+            return running_;
+        }
+
+        /// Non-blocking: returns true (once) when the search has finished, with the chosen move's index into rootMoves.
+        /// The mind's getLastSearchInfo() describes the finished search.
+        bool poll(unsigned int& moveIndex);
+
+        /// Seconds since start() was called.
+        inline double elapsedSeconds() const {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime_).count();
+        }
+
+        /// How far the running search has got.
+        inline SearchProgress getProgress() const {
+            return mind_->getProgress();
+        }
+
+        /// Asks the running search to finish now, without waiting for it. poll() then returns the best move of the deepest finished iteration,
+        /// so only stop a search once getProgress() shows it has finished one.
+        void stop();
+
+        /// Stops the running search (if any) and waits for the worker thread, throwing away the result.
+        void cancel();
+    };
+}
+
+#endif /* SearchJob_hpp */
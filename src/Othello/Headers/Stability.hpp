@@ -0,0 +1,28 @@
+//
+//  Stability.hpp
+//  Othello
+//
+//  Stable discs: discs that no sequence of moves can ever flip. Worked out for a whole side at once with bitboard operations.
+//
+
+#ifndef Stability_hpp
+#define Stability_hpp
+
+#include "Position.hpp"
+
+namespace othello {
+
+    /// Discs of 'mine' that can never be flipped, whatever either side plays. A disc is stable if:
+    /// - it's on an edge, and a precomputed table of every edge configuration says no play along that edge can flip it
+    ///   (a line through an edge disc in any other direction ends at the board edge, so it can't be flanked there), or
+    /// - in each of the 4 line directions through it, the line is full or a neighbor along it is one of my stable discs.
+    /// This can miss some stable discs, but never reports one that could be flipped.
+    Bitboard stableDiscs(Bitboard mine, Bitboard theirs);
+
+    /// Stable discs of 'who' in 'pos'.
+    inline Bitboard stableDiscs(const Position& pos, Side who) {
+        return stableDiscs(pos.discs[who], pos.discs[opponentOf(who)]);
+    }
+}
+
+#endif /* Stability_hpp */
@@ -0,0 +1,73 @@
+//
+//  ThreadPool.hpp
+//  Othello
+//
+//  Fixed set of worker threads that run submitted tasks in the order they were submitted.
+//  Each task is told which worker runs it, so callers can keep per-worker state without locking.
+//
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+namespace othello {
+
+    class ThreadPool {
+    public:
+        /// A unit of work. Called with the index (0 to size() - 1) of the worker running it.
+        typedef std::function<void(unsigned int)> Task;
+
+    private:
+        std::vector<std::thread> workers_;
+
+        /// Tasks not started yet, oldest first.
+        std::deque<Task> tasks_;
+
+        std::mutex mutex_;
+
+        /// Signalled when a task is queued or the pool is shutting down.
+        std::condition_variable taskReady_;
+
+        /// Signalled when the last running task finishes with nothing left in the queue.
+        std::condition_variable allDone_;
+
+        /// Tasks currently running.
+        unsigned int busy_;
+
+        bool stopping_;
+
+        /// Runs queued tasks until the pool is destroyed.
+        void workerLoop_(unsigned int workerId);
+
+    public:
+        /// Starts 'numThreads' workers (at least 1).
+        ThreadPool(unsigned int numThreads);
+
+        /// Finishes the queued tasks and joins every worker.
+        ~ThreadPool();
+
+        //disabled constructors & operators
+        ThreadPool() = delete;
+        ThreadPool(const ThreadPool& obj) = delete;
+        ThreadPool& operator = (const ThreadPool& obj) = delete;
+
+        /// Queues a task to run on the next free worker.
+        void submit(Task task);
+
+        /// Blocks until every submitted task has finished.
+        void wait();
+
+        /// Number of worker threads.
+        inline unsigned int size() const {
+            return (unsigned int)workers_.size();
+        }
+    };
+}
+
+#endif /* ThreadPool_hpp */
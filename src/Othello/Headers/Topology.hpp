@@ -0,0 +1,164 @@
+//
+//  Topology.hpp
+//  Othello
+//
+//  The board's geometry as compile-time tables: line directions, the squares next to & in line with each square, the corner, C and X squares,
+//  and which region each square is in. Everything here is constexpr, so the compiler folds it into the code that reads it and nothing is built at startup.
+//
+
+#ifndef Topology_hpp
+#define Topology_hpp
+
+#include <array>
+#include <cstdint>
+
+namespace othello {
+
+    /// One bit per board square. Square index = (y - 1) * 8 + (x - 1) for TilePoint{x, y}, so bit 0 is TilePoint{1, 1} and bit 63 is TilePoint{8, 8}.
+    typedef uint64_t Bitboard;
+
+    /// Number of squares on the board.
+    constexpr int NUM_SQUARES = 64;
+
+    /// Returns a bitboard with only the given square set.
+    constexpr Bitboard squareBit(int sq) {
+        return 1ULL << sq;
+    }
+
+    /// The columns & rows along the board's edges (x = 1, x = 8, y = 1, y = 8).
+    constexpr Bitboard COLUMN_1 = 0x0101010101010101ULL;
+    constexpr Bitboard COLUMN_8 = 0x8080808080808080ULL;
+    constexpr Bitboard ROW_1 = 0x00000000000000FFULL;
+    constexpr Bitboard ROW_8 = 0xFF00000000000000ULL;
+
+    /// Everything but an edge column: what's left after a shift towards higher / lower x, so discs don't wrap onto the next row.
+    constexpr Bitboard NOT_COLUMN_1 = ~COLUMN_1;
+    constexpr Bitboard NOT_COLUMN_8 = ~COLUMN_8;
+
+    /// Squares on the board's edges, and the ones off them.
+    constexpr Bitboard EDGE_SQUARES = COLUMN_1 | COLUMN_8 | ROW_1 | ROW_8;
+    constexpr Bitboard INNER_SQUARES = ~EDGE_SQUARES;
+
+    /// The four corner squares.
+    constexpr Bitboard CORNER_SQUARES = 0x8100000000000081ULL;
+
+    /// Edge squares next to a corner.
+    constexpr Bitboard C_SQUARES = 0x4281000000008142ULL;
+
+    /// Squares diagonally next to a corner.
+    constexpr Bitboard X_SQUARES = 0x0042000000004200ULL;
+
+    /// Squares touching a corner (the 'C' squares along the edges and the diagonal 'X' squares).
+    constexpr Bitboard CORNER_ADJ_SQUARES = C_SQUARES | X_SQUARES;
+
+    /// The four 4x4 quadrants, the regions endgame parity is counted in.
+    constexpr Bitboard QUADRANTS[4] = {
+        0x000000000F0F0F0FULL, 0x00000000F0F0F0F0ULL, 0x0F0F0F0F00000000ULL, 0xF0F0F0F000000000ULL
+    };
+
+    /// Number of directions a line of discs can run in.
+    constexpr int NUM_DIRECTIONS = 8;
+
+    /// Step in x & y of each direction, in the same order GameState has always scanned them: {0,-1}, {0,1}, {-1,0}, {1,0}, {-1,-1}, {1,1}, {-1,1}, {1,-1}.
+    constexpr int DIRECTION_DX[NUM_DIRECTIONS] = {0, 0, -1, 1, -1, 1, -1, 1};
+    constexpr int DIRECTION_DY[NUM_DIRECTIONS] = {-1, 1, 0, 0, -1, 1, 1, -1};
+
+    /// Shifts every disc of 'b' one square in direction 'dir', dropping discs that would wrap around the board edge.
+    constexpr Bitboard shiftDir(Bitboard b, int dir) {
+        switch (dir) {
+            case 0: return b >> 8;                  // {0, -1}
+            case 1: return b << 8;                  // {0, 1}
+            case 2: return (b >> 1) & NOT_COLUMN_8; // {-1, 0}
+            case 3: return (b << 1) & NOT_COLUMN_1; // {1, 0}
+            case 4: return (b >> 9) & NOT_COLUMN_8; // {-1, -1}
+            case 5: return (b << 9) & NOT_COLUMN_1; // {1, 1}
+            case 6: return (b << 7) & NOT_COLUMN_8; // {-1, 1}
+            case 7: return (b >> 7) & NOT_COLUMN_1; // {1, -1}
+        }
+        return 0;
+    }
+
+    /// Squares adjacent (including diagonals) to any square of 'b'.
+    constexpr Bitboard neighborsOf(Bitboard b) {
+        // one step sideways, then the row of that (and b itself) one step up and down
+        Bitboard sideways = ((b << 1) & NOT_COLUMN_1) | ((b >> 1) & NOT_COLUMN_8);
+        Bitboard row = sideways | b;
+        return sideways | (row << 8) | (row >> 8);
+    }
+
+    /// Column 'x' (0-7) of 'b' as a byte (bit i = row i).
+    constexpr unsigned int columnByte(Bitboard b, int x) {
+        return (unsigned int)((((b >> x) & COLUMN_1) * 0x0102040810204080ULL) >> 56);
+    }
+
+    /// What kind of square each one is, roughly by how much it's worth holding.
+    enum SquareRegion : unsigned char {
+        REGION_CORNER,
+        REGION_C,
+        REGION_X,
+        /// Edge squares other than corners and C-squares.
+        REGION_EDGE,
+        REGION_INNER
+    };
+
+    namespace topology {
+        constexpr std::array<Bitboard, NUM_SQUARES> makeNeighbors() {
+            std::array<Bitboard, NUM_SQUARES> neighbors = {};
+            for (int sq = 0; sq < NUM_SQUARES; sq++) {
+                neighbors[sq] = neighborsOf(squareBit(sq));
+            }
+            return neighbors;
+        }
+
+        constexpr std::array<std::array<Bitboard, NUM_DIRECTIONS>, NUM_SQUARES> makeRays() {
+            std::array<std::array<Bitboard, NUM_DIRECTIONS>, NUM_SQUARES> rays = {};
+            for (int sq = 0; sq < NUM_SQUARES; sq++) {
+                for (int d = 0; d < NUM_DIRECTIONS; d++) {
+                    for (Bitboard cur = shiftDir(squareBit(sq), d); cur; cur = shiftDir(cur, d)) {
+                        rays[sq][d] |= cur;
+                    }
+                }
+            }
+            return rays;
+        }
+
+        constexpr std::array<Bitboard, 256> makeColumnSpread() {
+            std::array<Bitboard, 256> spread = {};
+            for (int b = 0; b < 256; b++) {
+                for (int i = 0; i < 8; i++) {
+                    if (b & (1 << i))
+                        spread[b] |= squareBit(8 * i);
+                }
+            }
+            return spread;
+        }
+
+        constexpr std::array<SquareRegion, NUM_SQUARES> makeRegions() {
+            std::array<SquareRegion, NUM_SQUARES> regions = {};
+            for (int sq = 0; sq < NUM_SQUARES; sq++) {
+                Bitboard bit = squareBit(sq);
+                regions[sq] = (bit & CORNER_SQUARES) ? REGION_CORNER : (bit & C_SQUARES) ? REGION_C : (bit & X_SQUARES) ? REGION_X :
+                              (bit & EDGE_SQUARES) ? REGION_EDGE : REGION_INNER;
+            }
+            return regions;
+        }
+    }
+
+    /// The squares next to each square.
+    constexpr std::array<Bitboard, NUM_SQUARES> NEIGHBORS = topology::makeNeighbors();
+
+    /// For each square & direction, the squares from it (itself not included) to the edge of the board.
+    constexpr std::array<std::array<Bitboard, NUM_DIRECTIONS>, NUM_SQUARES> RAYS = topology::makeRays();
+
+    /// A byte's bits spread onto column 1 (bit i goes to square 8 * i): the inverse of columnByte(b, 0).
+    constexpr std::array<Bitboard, 256> COLUMN_SPREAD = topology::makeColumnSpread();
+
+    /// The region of each square.
+    constexpr std::array<SquareRegion, NUM_SQUARES> SQUARE_REGION = topology::makeRegions();
+
+    static_assert(NEIGHBORS[0] == 0x0000000000000302ULL, "a corner has 3 neighbors");
+    static_assert((RAYS[0][5] | squareBit(0)) == 0x8040201008040201ULL, "the long diagonal runs corner to corner");
+    static_assert(CORNER_ADJ_SQUARES == 0x42C300000000C342ULL, "C & X squares touch the corners");
+}
+
+#endif /* Topology_hpp */
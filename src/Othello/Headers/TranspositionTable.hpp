@@ -0,0 +1,180 @@
+//
+//  TranspositionTable.hpp
+//  Othello
+//
+//  Fixed-size hash table of previously searched positions, keyed by Zobrist hash.
+//  Lives in AiMind and persists across turns, so positions reached again (by another move order, or on the next turn) aren't searched twice.
+//  Shared by all search threads without locks: each slot stores its key XORed with its data, so a slot torn by two threads writing
+//  at once no longer matches any key and just reads as a miss.
+//
+
+#ifndef TranspositionTable_hpp
+#define TranspositionTable_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+namespace othello {
+
+    /// How an entry's score relates to the position's real minimax value.
+    enum class BoundType : uint8_t {
+        NONE = 0,   // empty slot
+        EXACT,      // score is the exact value
+        LOWER,      // real value >= score (the search failed high)
+        UPPER       // real value <= score (the search failed low)
+    };
+
+    /// Which entry a new result evicts when its bucket is full.
+    enum class ReplacementPolicy {
+        /// New results always go in, evicting the shallower of the two entries.
+        ALWAYS_REPLACE,
+        /// New results only evict an entry searched to the same depth or shallower (or left over from an earlier search).
+        DEPTH_PREFERRED,
+        /// First slot of each bucket is depth-preferred, the second always takes whatever the first slot rejects.
+        TWO_TIER
+    };
+
+    struct TTEntry {
+        /// Full hash of the stored position (to tell apart positions sharing a bucket).
+        uint64_t key;
+        /// Score, as returned by the search that stored it.
+        int32_t score;
+        /// Best (or refuting) move found, or -1 if none.
+        int8_t bestMove;
+        /// Remaining search depth the score was computed with.
+        uint8_t depth;
+        BoundType bound;
+        /// Search generation that stored this entry (see newSearch()).
+        uint8_t age;
+    };
+
+    /// Counters for sizing the table. Each search thread keeps its own and adds them to the table's totals with addStats().
+    struct TTStats {
+        uint64_t probes;
+        uint64_t hits;
+        uint64_t stores;
+        /// Stores that evicted a different position.
+        uint64_t overwrites;
+        /// Stores that were rejected by the replacement policy.
+        uint64_t rejected;
+
+        /// Fraction of probes that found their position.
+        inline double hitRate() const {
+            return probes ? (double)hits / probes : 0.0;
+        }
+
+        inline TTStats& operator += (const TTStats& other) {
+            probes += other.probes;
+            hits += other.hits;
+            stores += other.stores;
+            overwrites += other.overwrites;
+            rejected += other.rejected;
+            return *this;
+        }
+    };
+
+    class TranspositionTable {
+    private:
+        /// Each bucket holds this many entries.
+        static const unsigned int BUCKET_SIZE_;
+
+        /// One stored entry: everything but the key packed into 'data', and 'check' = key ^ data.
+        /// Relaxed atomics cost the same as plain loads & stores, but make concurrent access well-defined.
+        struct Slot {
+            std::atomic<uint64_t> check;
+            std::atomic<uint64_t> data;
+        };
+
+        std::unique_ptr<Slot[]> slots_;
+        size_t numSlots_;
+
+        /// numBuckets - 1 (the number of buckets is always a power of 2).
+        uint64_t bucketMask_;
+
+        ReplacementPolicy policy_;
+
+        /// Current search generation, stamped on every stored entry.
+        uint8_t age_;
+
+        /// Totals added by addStats().
+        TTStats stats_;
+
+        /// Packs / unpacks an entry's data word.
+        static uint64_t pack_(const TTEntry& entry);
+        static TTEntry unpack_(uint64_t key, uint64_t data);
+
+        /// Reads a slot; an empty or torn slot comes back with bound NONE.
+        static TTEntry read_(const Slot& slot);
+        static void write_(Slot& slot, const TTEntry& entry);
+
+    public:
+        /// Creates a table using roughly (at most) 'sizeMB' megabytes.
+        /// @param sizeMB Memory budget in megabytes; rounded down to a power-of-two number of buckets.
+        /// @param policy How new entries replace old ones.
+        TranspositionTable(size_t sizeMB, ReplacementPolicy policy);
+
+        //disabled constructors & operators
+        TranspositionTable() = delete;
+        TranspositionTable(const TranspositionTable& obj) = delete;
+        TranspositionTable& operator = (const TranspositionTable& obj) = delete;
+
+        /// Reallocates the table to the new size (which also clears it).
+        void resize(size_t sizeMB);
+
+        /// Empties every entry. Statistics are kept. Not safe while a search is running.
+        void clear();
+
+        /// Marks the start of a new search, so entries from older searches become the first to be replaced.
+        void newSearch();
+
+        /// Looks up a position. Returns true (and fills 'out') if it's stored. Safe to call from several threads at once.
+        /// @param key The position's Zobrist hash.
+        /// @param out Set to the stored entry if found.
+        /// @param stats The calling thread's counters.
+        bool probe(uint64_t key, TTEntry& out, TTStats& stats) const;
+
+        /// Stores a search result, subject to the replacement policy.
+        /// @param key The position's Zobrist hash.
+        /// @param depth Remaining search depth the score was computed with.
+        /// @param bound How the score relates to the real value.
+        /// @param score The search result.
+        /// @param bestMove The best move found, or -1.
+        /// @param stats The calling thread's counters.
+        void store(uint64_t key, unsigned int depth, BoundType bound, int score, int bestMove, TTStats& stats);
+
+        inline void setPolicy(ReplacementPolicy policy) {
+            policy_ = policy;
+        }
+
+        inline ReplacementPolicy getPolicy() const {
+            return policy_;
+        }
+
+        /// Total number of entry slots.
+        inline size_t numEntries() const {
+            return numSlots_;
+        }
+
+        /// Size of the table in bytes.
+        inline size_t sizeBytes() const {
+            return numSlots_ * sizeof(Slot);
+        }
+
+        /// Adds a search thread's counters to the totals.
+        inline void addStats(const TTStats& stats) {
+            stats_ += stats;
+        }
+
+        inline const TTStats& getStats() const {
+            return stats_;
+        }
+
+        inline void resetStats() {
+            stats_ = TTStats{};
+        }
+    };
+}
+
+#endif /* TranspositionTable_hpp */
@@ -0,0 +1,32 @@
+//
+//  Zobrist.hpp
+//  Othello
+//
+//  Zobrist hashing for bitboard Positions. A position's hash is the XOR of one random key per (side, square) disc,
+//  plus a key when white is to move, so a move can update it by XOR-ing in only the squares it changed.
+//
+
+#ifndef Zobrist_hpp
+#define Zobrist_hpp
+
+#include <cstdint>
+#include "Position.hpp"
+
+namespace othello {
+    namespace zobrist {
+        /// Key for a disc of 'side' on square 'sq'.
+        uint64_t squareKey(Side side, int sq);
+
+        /// Key XOR-ed in when white is to move.
+        uint64_t whiteToMoveKey();
+
+        /// Computes a position's hash from scratch.
+        uint64_t hashOf(const Position& pos);
+
+        /// Returns the value to XOR into a position's hash to apply (or, since XOR is its own inverse, take back) a move.
+        /// @param move The record returned by Position::makeMove().
+        uint64_t moveDelta(const MoveUndo& move);
+    }
+}
+
+#endif /* Zobrist_hpp */
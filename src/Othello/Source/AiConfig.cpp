@@ -0,0 +1,19 @@
+//
+//  AiConfig.cpp
+//  Othello
+//
+
+#include "AiConfig.hpp"
+#include <thread>
+
+using namespace othello;
+
+
+std::shared_ptr<AiMind> othello::makeDefaultMind() {
+    auto mind = std::make_shared<AiMind>(NUM_DISC_WEIGHT, MOBILITY_WEIGHT, STABILITY_WEIGHT, CORNER_WEIGHT, CORNER_ADJ_WEIGHT, NUM_FRONTIER_WEIGHT);
+    mind->configureTranspositionTable(TT_SIZE_MB, TT_POLICY);
+    mind->setSearchThreads(AI_SEARCH_THREADS ? AI_SEARCH_THREADS : std::thread::hardware_concurrency());
+    mind->setEvaluator(AI_EVALUATOR);
+    mind->setSearchStats(AI_SEARCH_STATS);
+    return mind;
+}
@@ -6,139 +6,840 @@
 //
 
 #include "AiMind.hpp"
+#include "Zobrist.hpp"
+#include "Stability.hpp"
+#include "Profiler.hpp"
 #include <iostream>
+#include <climits>
+#include <numeric>
+#include <algorithm>
+#include <mutex>
+#include <thread>
 
 
 using namespace std;
 using namespace othello;
 
-RGBColor AiMind::WHITE = RGBColor{1, 1, 1};
-RGBColor AiMind::BLACK = RGBColor{0, 0, 0};
 
+// scores are stored from the AI's point of view, so searches for white must not share entries with searches for black
+static const uint64_t WHITE_PERSPECTIVE_KEY = 0xD1B54A32D192ED03ULL;
 
-AiMind::AiMind(unsigned int discWeight, unsigned int mobilityWeight, unsigned int stabilityWeight, unsigned int cornerWeight, int cornerAdjWeight, int frontierWeight, RGBColor defaultTileCol)
+// table size until configureTranspositionTable is called
+static const size_t DEFAULT_TT_SIZE_MB = 16;
+
+// how many nodes to search between looks at the clock
+static const uint64_t NODES_BETWEEN_LIMIT_CHECKS = 1024;
+
+const int AiMind::ASPIRATION_WINDOW_ = 10;
+
+const double AiMind::SOLVE_TIME_SHARE_ = 0.5;
+
+// the endgame solver's table; its positions have few empties, so it needn't be big
+static const size_t ENDGAME_TT_SIZE_MB = 16;
+
+// by default, solve exactly at 16 empties and for win/loss/draw at 20 (both usually well under a second)
+static const unsigned int DEFAULT_EXACT_SOLVE_EMPTIES = 16;
+static const unsigned int DEFAULT_WLD_SOLVE_EMPTIES = 20;
+
+// splitting a node costs a copy of its position & moves, which only pays off with a few plies left to search below it
+const unsigned int AiMind::MIN_SPLIT_DEPTH_ = 3;
+
+
+/// Shared by the threads searching the root moves: the window and the best move found so far by any of them.
+struct AiMind::RootSearch {
+    Side aiSide;
+    const std::vector<int>& rootMoves;
+    const std::vector<unsigned int>& searchOrder;
+    std::vector<int>& moveScores;
+    unsigned int depth;
+    int alpha;
+    int beta;
+    
+    /// Guards everything below.
+    std::mutex mutex;
+    bool haveBest;
+    int bestScore;
+    unsigned int bestInd;
+    std::vector<int> pv;
+    
+    /// Set when a move scores beta or more: the caller widens the window & searches again, so the remaining moves can stop.
+    std::atomic<bool> failedHigh;
+    
+    /// Next entry of searchOrder to hand out. The first move is searched before any other is handed out.
+    std::atomic<unsigned int> nextMove;
+    std::atomic<bool> firstDone;
+    
+    /// Root moves not finished yet; the threads keep helping each other until it reaches 0.
+    std::atomic<unsigned int> unfinished;
+    
+    RootSearch(Side aiSide, const std::vector<int>& rootMoves, const std::vector<unsigned int>& searchOrder, std::vector<int>& moveScores, unsigned int depth, int alpha, int beta)
+        :   aiSide(aiSide), rootMoves(rootMoves), searchOrder(searchOrder), moveScores(moveScores), depth(depth), alpha(alpha), beta(beta),
+            haveBest(false), bestScore(-SCORE_INFINITY), bestInd(0), failedHigh(false),
+            nextMove(1), firstDone(false), unfinished((unsigned int)searchOrder.size()) {}
+};
+
+
+/// A node whose remaining moves are shared out between threads (after its first move was searched alone).
+/// Lives on the owning thread's stack until every thread that joined it has left.
+struct AiMind::SplitPoint {
+    /// Split point the owner was searching under when it made this one; cancelling it cancels this one too.
+    SplitPoint* parent;
+    
+    Position pos;
+    uint64_t hash;
+    EvalState evalState;
+    unsigned int ply;
+    unsigned int depth;
+    Side aiSide;
+    
+    /// Moves still to share out (the first one is already searched), best first.
+    ScoredMove moves[NUM_SQUARES];
+    unsigned int numMoves;
+    std::atomic<unsigned int> nextMove;
+    
+    /// Threads other than the owner searching moves of this split point.
+    std::atomic<unsigned int> helpers;
+    
+    /// Set when a move fails high: the other moves' results aren't needed any more.
+    std::atomic<bool> cancelled;
+    
+    int beta;
+    
+    /// Guards everything below.
+    std::mutex mutex;
+    int alpha;
+    int bestScore;
+    int bestMove;
+    int pv[NUM_SQUARES + 1];
+    unsigned int pvLength;
+    
+    SplitPoint()
+        :   nextMove(0), helpers(0), cancelled(false) {}
+};
+
+
+static uint64_t searchHashOf(const Position& pos, Side aiSide) {
+    return zobrist::hashOf(pos) ^ (aiSide == SIDE_WHITE ? WHITE_PERSPECTIVE_KEY : 0);
+}
+
+
+AiMind::SearchThread::SearchThread()
+    :   pos(Position::empty()),
+        hash(0),
+        plyBase(0),
+        activeSplit(nullptr),
+        nodes(0),
+        leafEvals(0),
+        plyStats{},
+        ttStats(TTStats{})
+{
+    // a game never lasts more than one move per square
+    undoStack.reserve(NUM_SQUARES);
+}
+
+
+AiMind::AiMind(unsigned int discWeight, unsigned int mobilityWeight, unsigned int stabilityWeight, unsigned int cornerWeight, int cornerAdjWeight, int frontierWeight)
     :
     MOBILITY_WEIGHT_(mobilityWeight),
     STABILITY_WEIGHT_(stabilityWeight),
     CORNER_WEIGHT_(cornerWeight),
-    CORNER_ADJ_WEIGHT_(cornerAdjWeight),
     NUM_FRONTIER_WEIGHT_(frontierWeight),
+    CORNER_ADJ_WEIGHT_(cornerAdjWeight),
     NUM_DISC_WEIGHT_(discWeight),
-    DEFAULT_TILE_COLOR_(defaultTileCol)
+    transTable_(DEFAULT_TT_SIZE_MB, ReplacementPolicy::TWO_TIER),
+    rootPos_(Position::empty()),
+    rootHash_(0),
+    sharedNodes_(0),
+    nodeLimit_(0),
+    hasDeadline_(false),
+    stopFlag_(nullptr),
+    iterationsDone_(0),
+    progressBestMove_(NO_SQUARE),
+    idleThreads_(0),
+    workEpoch_(0),
+    searchAborted_(false),
+    canAbort_(false),
+    lastSearch_(SearchInfo{0, 0, {}, 0, 0, {}, false, false, {}, false, 0, {}, TTStats{}}),
+    searchStats_(false),
+    endgameSolver_(ENDGAME_TT_SIZE_MB),
+    exactSolveEmpties_(DEFAULT_EXACT_SOLVE_EMPTIES),
+    winLossDrawSolveEmpties_(DEFAULT_WLD_SOLVE_EMPTIES),
+    openingBook_(nullptr),
+    patternEval_((int)discWeight, (int)mobilityWeight, (int)stabilityWeight, (int)cornerWeight, cornerAdjWeight, frontierWeight),
+    evaluator_(Evaluator::PATTERNS),
+    orderingStages_(ORDER_ALL),
+    orderingStats_(OrderingStats{})
 {
+    setSearchThreads(1);
+}
+
+
+void AiMind::setSearchThreads(unsigned int numThreads) {
+    if (numThreads == 0)
+        numThreads = 1;
+    threadPool_.reset();
+    threads_.resize(numThreads);
+    for (auto& t : threads_) {
+        if (!t) {
+            t = std::make_unique<SearchThread>();
+            t->orderer.setStages(orderingStages_);
+        }
+    }
+    // the calling thread is the first search thread, the pool provides the others
+    if (numThreads > 1)
+        threadPool_ = std::make_unique<ThreadPool>(numThreads - 1);
+}
+
+
+void AiMind::setEndgameSolve(unsigned int exactEmpties, unsigned int winLossDrawEmpties) {
+    exactSolveEmpties_ = exactEmpties;
+    winLossDrawSolveEmpties_ = winLossDrawEmpties;
+}
+
+
+void AiMind::setOpeningBook(std::shared_ptr<const OpeningBook> book) {
+    openingBook_ = std::move(book);
+}
+
+
+bool AiMind::probeBook_(const std::vector<int>& rootMoves, unsigned int& bestInd) {
+    BookMove move;
+    if (!openingBook_ || !openingBook_->lookup(rootPos_, move))
+        return false;
+    auto it = std::find(rootMoves.begin(), rootMoves.end(), move.square);
+    if (it == rootMoves.end())
+        return false; // a book built for different rules or a damaged file: search instead
     
+    bestInd = (unsigned int)(it - rootMoves.begin());
+    lastSearch_.depthReached = move.depth;
+    lastSearch_.score = move.score;
+    lastSearch_.principalVariation = {move.square};
+    lastSearch_.fromBook = true;
+    iterationsDone_ = 1;
+    progressBestMove_ = move.square;
+    return true;
+}
+
+
+bool AiMind::solveEndgame_(const std::vector<int>& rootMoves, const SearchLimits& limits, std::chrono::steady_clock::time_point startTime, unsigned int& bestInd) {
+    unsigned int empties = rootPos_.numEmpties();
+    if (rootMoves.empty() || (empties > std::max(exactSolveEmpties_, winLossDrawSolveEmpties_)))
+        return false;
+    SolveMode mode = (empties <= exactSolveEmpties_) ? SolveMode::EXACT : SolveMode::WIN_LOSS_DRAW;
+    
+    endgameSolver_.setStopFlag(limits.stopFlag);
+    if (limits.maxSeconds > 0)
+        endgameSolver_.setDeadline(startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(limits.maxSeconds * SOLVE_TIME_SHARE_)));
+    else
+        endgameSolver_.clearDeadline();
+    EndgameResult result;
+    bool solved = endgameSolver_.solve(rootPos_, rootMoves, mode, result);
+    endgameSolver_.setStopFlag(nullptr);
+    if (!solved)
+        return false;
+    
+    bestInd = (unsigned int)(std::find(rootMoves.begin(), rootMoves.end(), result.bestMove) - rootMoves.begin());
+    lastSearch_.depthReached = empties;
+    lastSearch_.nodes = result.nodes;
+    lastSearch_.score = result.score;
+    lastSearch_.principalVariation = {result.bestMove};
+    lastSearch_.solved = true;
+    iterationsDone_ = 1;
+    progressBestMove_ = result.bestMove;
+    return true;
+}
+
+
+void AiMind::setEvaluator(Evaluator evaluator) {
+    evaluator_ = evaluator;
+    transTable_.clear(); // stored scores came from the other evaluation
+}
+
+
+void AiMind::clearSearchState() {
+    transTable_.clear();
+    endgameSolver_.clearTable();
+    for (auto& t : threads_) {
+        t->orderer.clear();
+    }
+}
+
+
+void AiMind::setOrderingStages(unsigned int stages) {
+    orderingStages_ = stages;
+    for (auto& t : threads_) {
+        t->orderer.setStages(stages);
+    }
+}
+
+
+void AiMind::resetThread_(SearchThread& t, const Position& pos, uint64_t hash) {
+    t.pos = pos;
+    t.hash = hash;
+    PatternEvaluator::initState(pos, t.evalState);
+    t.undoStack.clear();
+    t.plyBase = 0;
+    t.activeSplit = nullptr;
+}
+
+
+void AiMind::collectThreadStats_() {
+    for (auto& t : threads_) {
+        transTable_.addStats(t->ttStats);
+        t->ttStats = TTStats{};
+        orderingStats_ += t->orderer.getStats();
+        t->orderer.resetStats();
+    }
+}
+
+
+void AiMind::makeMove_(SearchThread& t, Side mover, int sq) {
+    t.pos.toMove = mover;
+    if (mover == SIDE_BLACK)
+        makeMove_<SIDE_BLACK>(t, sq);
+    else
+        makeMove_<SIDE_WHITE>(t, sq);
+}
+
+
+template <Side MOVER>
+void AiMind::makeMove_(SearchThread& t, int sq) {
+    t.undoStack.push_back(t.pos.makeMoveAs<MOVER>(sq));
+    t.hash ^= zobrist::moveDelta(t.undoStack.back());
+    if (evaluator_ == Evaluator::PATTERNS)
+        PatternEvaluator::applyMove(t.evalState, t.undoStack.back());
+}
+
+
+void AiMind::unmakeMove_(SearchThread& t) {
+    if (t.undoStack.back().mover == SIDE_BLACK)
+        unmakeMove_<SIDE_BLACK>(t);
+    else
+        unmakeMove_<SIDE_WHITE>(t);
+}
+
+
+template <Side MOVER>
+void AiMind::unmakeMove_(SearchThread& t) {
+    t.hash ^= zobrist::moveDelta(t.undoStack.back());
+    if (evaluator_ == Evaluator::PATTERNS)
+        PatternEvaluator::undoMove(t.evalState, t.undoStack.back());
+    t.pos.unmakeMoveAs<MOVER>(t.undoStack.back());
+    t.undoStack.pop_back();
+}
+
+
+void AiMind::countNode_(SearchThread& t) {
+    t.nodes++;
+    if ((t.nodes % NODES_BETWEEN_LIMIT_CHECKS) != 0)
+        return;
+    uint64_t totalNodes = sharedNodes_.fetch_add(NODES_BETWEEN_LIMIT_CHECKS, std::memory_order_relaxed) + NODES_BETWEEN_LIMIT_CHECKS;
+    if (stopFlag_ && stopFlag_->load(std::memory_order_relaxed))
+        searchAborted_ = true;
+    if (!canAbort_)
+        return;
+    if ((nodeLimit_ != 0) && (totalNodes >= nodeLimit_))
+        searchAborted_ = true;
+    if (hasDeadline_ && (std::chrono::steady_clock::now() >= deadline_))
+        searchAborted_ = true;
+}
+
+
+void AiMind::countCutoff_(SearchThread& t, unsigned int ply, unsigned int moveIndex) {
+    if (!searchStats_)
+        return;
+    t.plyStats[ply].cutoffs++;
+    if (moveIndex == 0)
+        t.plyStats[ply].firstMoveCutoffs++;
+}
+
+
+void AiMind::collectSearchStats_() {
+    lastSearch_.detailed = true;
+    lastSearch_.plies.assign(NUM_SQUARES + 1, PlyStats{0, 0, 0});
+    for (auto& t : threads_) {
+        lastSearch_.leafEvaluations += t->leafEvals;
+        for (unsigned int p = 0; p <= NUM_SQUARES; p++) {
+            lastSearch_.plies[p].nodes += t->plyStats[p].nodes;
+            lastSearch_.plies[p].cutoffs += t->plyStats[p].cutoffs;
+            lastSearch_.plies[p].firstMoveCutoffs += t->plyStats[p].firstMoveCutoffs;
+        }
+    }
+    while (!lastSearch_.plies.empty() && (lastSearch_.plies.back().nodes == 0)) {
+        lastSearch_.plies.pop_back();
+    }
+}
+
+
+void AiMind::configureTranspositionTable(size_t sizeMB, ReplacementPolicy policy) {
+    transTable_.setPolicy(policy);
+    transTable_.resize(sizeMB);
+}
+
+
+template <Side AI_SIDE, Side MOVER>
+int AiMind::leafScore_(SearchThread& t) {
+    if (searchStats_)
+        t.leafEvals++;
+    int score = (evaluator_ == Evaluator::PATTERNS) ? patternEval_.evaluate(t.pos, t.evalState, AI_SIDE) : evalWeights_(t.pos, AI_SIDE);
+    return (MOVER == AI_SIDE) ? score : -score;
+}
+
+
+int AiMind::minimax(bool maximizing, unsigned int depth, const Position& pos, Side aiSide, int alpha, int beta) {
+    PROFILE_ZONE("AiMind::minimax"); // only othello-bench calls this; the game & othello-cli search through bestMove()
+    // minimax scores are from the AI's point of view, negamax scores from the side to move's
+    alpha = std::max(alpha, -SCORE_INFINITY);
+    beta = std::min(beta, SCORE_INFINITY);
+    Position searchPos = pos;
+    searchPos.toMove = maximizing ? aiSide : opponentOf(aiSide);
+    if (maximizing)
+        return negamax(depth, searchPos, aiSide, alpha, beta);
+    return -negamax(depth, searchPos, aiSide, -beta, -alpha);
+}
+
+
+int AiMind::negamax(unsigned int depth, const Position& pos, Side aiSide, int alpha, int beta) {
+    SearchThread& t = *threads_[0];
+    resetThread_(t, pos, searchHashOf(pos, aiSide));
+    searchAborted_ = false;
+    int score = negamax_(t, depth, aiSide, alpha, beta);
+    collectThreadStats_();
+    return score;
 }
 
 
-int AiMind::minimax(bool maximizing, unsigned int depth, shared_ptr<Player>& playerBlack, shared_ptr<Player>& playerWhite, shared_ptr<Board>& thisBoard, shared_ptr<GameState>& layout, int alpha, int beta) {
+int AiMind::negamax_(SearchThread& t, unsigned int depth, Side aiSide, int alpha, int beta) {
+    if (aiSide == SIDE_BLACK) {
+        if (t.pos.toMove == SIDE_BLACK)
+            return negamax_<SIDE_BLACK, SIDE_BLACK>(t, depth, alpha, beta);
+        return negamax_<SIDE_BLACK, SIDE_WHITE>(t, depth, alpha, beta);
+    }
+    if (t.pos.toMove == SIDE_BLACK)
+        return negamax_<SIDE_WHITE, SIDE_BLACK>(t, depth, alpha, beta);
+    return negamax_<SIDE_WHITE, SIDE_WHITE>(t, depth, alpha, beta);
+}
+
+
+template <Side AI_SIDE, Side MOVER>
+int AiMind::negamax_(SearchThread& t, unsigned int depth, int alpha, int beta) {
+    // every child is the opponent's instantiation, so nothing below looks at pos.toMove or which side the AI is
+    constexpr Side OPPONENT = opponentOf(MOVER);
+    countNode_(t);
+    if (stopped_(t)) // out of budget or cut off elsewhere, this result will be thrown away
+        return 0;
+    
+    Position& pos = t.pos;
+    unsigned int ply = t.ply();
+    t.pvLength[ply] = ply;
+    if (searchStats_)
+        t.plyStats[ply].nodes++;
+    
     if (depth == 0) //or game is over // base case
-        return evalGamestateScore(playerBlack, layout);
+        return leafScore_<AI_SIDE, MOVER>(t);
+    
+    // have we already searched this position?
+    int alphaOrig = alpha, betaOrig = beta;
+    int hashMove = NO_SQUARE;
+    TTEntry entry;
+    if (transTable_.probe(t.hash, entry, t.ttStats)) {
+        hashMove = entry.bestMove;
+        // a score searched at least this deep is at least as good as searching it again (this is what carries earlier iterations & moves over)
+        if (entry.depth >= depth) {
+            if (entry.bound == BoundType::EXACT)
+                return entry.score;
+            if (entry.bound == BoundType::LOWER)
+                alpha = std::max(alpha, (int)entry.score);
+            else if (entry.bound == BoundType::UPPER)
+                beta = std::min(beta, (int)entry.score);
+            if (beta <= alpha)
+                return entry.score;
+        }
+    }
+    
+    Bitboard possibleMoves = pos.legalMoves(MOVER);
+    if (possibleMoves == 0) { // no more moves for this player
+        return leafScore_<AI_SIDE, MOVER>(t);
+    }
     
-    std::vector<std::shared_ptr<Tile>> possibleMoves;
+    // try the moves most likely to cause a cutoff first
+    ScoredMove orderedMoves[NUM_SQUARES];
+    unsigned int numMoves = t.orderer.orderMoves(pos, MOVER, possibleMoves, hashMove, ply, depth, orderedMoves);
     
-    if (maximizing) {
-        // simulate black placing a piece that puts them at the largest advantage
-        layout->getPlayableTiles(playerBlack, possibleMoves);
-        if (possibleMoves.size() == 0) { // no more moves for black
-            return evalGamestateScore(playerBlack, layout);
+    int bestScore = -SCORE_INFINITY;
+    int bestMove = NO_SQUARE;
+    for (unsigned int m = 0; m < numMoves; m++) {
+        // young brothers wait: once the first move is searched (without a cutoff), idle threads can help with the rest
+        if ((m == 1) && (depth >= MIN_SPLIT_DEPTH_) && (idleThreads_.load(std::memory_order_relaxed) > 0)) {
+            splitSearch_(t, depth, AI_SIDE, alpha, beta, bestScore, bestMove, orderedMoves + 1, numMoves - 1);
+            break;
+        }
+        
+        int sq = orderedMoves[m].square;
+        makeMove_<MOVER>(t, sq);
+        int score;
+        if (m == 0) {
+            score = -negamax_<AI_SIDE, OPPONENT>(t, depth - 1, -beta, -alpha);
+        } else {
+            // prove this move is no better than the best so far with a null window, and only search it properly if it is
+            score = -negamax_<AI_SIDE, OPPONENT>(t, depth - 1, -alpha - 1, -alpha);
+            if ((score > alpha) && (score < beta) && !stopped_(t))
+                score = -negamax_<AI_SIDE, OPPONENT>(t, depth - 1, -beta, -alpha);
         }
-        int maxEval = INT_MIN;
-        for (unsigned int i = 0; i < possibleMoves.size(); i++) {
-            shared_ptr<Tile> thisMove = possibleMoves[i];
-            int eval = applyMinimaxMove_(maximizing, depth, thisMove, thisBoard, alpha, beta);
-            maxEval = std::max(maxEval, eval);
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha) {
-                break; // alpha-beta pruning
+        unmakeMove_<MOVER>(t);
+        if (stopped_(t)) // don't store a half-searched result
+            return 0;
+        
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = sq;
+            if (score > alpha) {
+                alpha = score;
+                // best line from here is this move followed by the child's best line
+                t.pvTable[ply][ply] = sq;
+                for (unsigned int p = ply + 1; p < t.pvLength[ply + 1]; p++) {
+                    t.pvTable[ply][p] = t.pvTable[ply + 1][p];
+                }
+                t.pvLength[ply] = std::max(t.pvLength[ply + 1], ply + 1);
             }
         }
-        return maxEval;
-    } else {
-        // simulate white placing the piece which puts black at the largest disadvantage
-        layout->getPlayableTiles(playerWhite, possibleMoves);
-        if (possibleMoves.size() == 0) { // no more moves for white
-            return evalGamestateScore(playerBlack, layout);
+        if (alpha >= beta) {
+            t.orderer.recordCutoff(MOVER, sq, ply, depth, m);
+            countCutoff_(t, ply, m);
+            break; // alpha-beta pruning
         }
-        int minEval = INT_MAX;
-        for (unsigned int i = 0; i < possibleMoves.size(); i++) {
-            shared_ptr<Tile> thisMove = possibleMoves[i];
-            int eval = applyMinimaxMove_(maximizing, depth, thisMove, thisBoard, alpha, beta);
-            minEval = std::min(minEval, eval);
-            beta = std::min(beta, eval);
-            if (beta <= alpha) {
-                break; // alpha-beta pruning
-            }
+    }
+    if (stopped_(t))
+        return 0;
+    
+    BoundType bound = BoundType::EXACT;
+    if (bestScore <= alphaOrig)
+        bound = BoundType::UPPER;
+    else if (bestScore >= betaOrig)
+        bound = BoundType::LOWER;
+    transTable_.store(t.hash, depth, bound, bestScore, bestMove, t.ttStats);
+    return bestScore;
+}
+
+
+int AiMind::searchRoot_(Side aiSide, const std::vector<int>& rootMoves, const std::vector<unsigned int>& searchOrder, std::vector<int>& moveScores, unsigned int depth, int alpha, int beta, unsigned int& bestInd, std::vector<int>& pv) {
+    RootSearch root(aiSide, rootMoves, searchOrder, moveScores, depth, alpha, beta);
+    
+    // the other threads start right away, helping with the split points inside the first move until it's done
+    if (threadPool_) {
+        for (unsigned int w = 0; w < threadPool_->size(); w++) {
+            threadPool_->submit([this, &root](unsigned int worker) {
+                helperLoop_(*threads_[worker + 1], root);
+            });
         }
-        return minEval;
-    }
-}
-
-int AiMind::applyMinimaxMove_(bool maxing, unsigned int depth, shared_ptr<Tile>& thisMove, shared_ptr<Board>& oldBoard, int alpha, int beta) {
-    // each hypothetical move needs a new board object, thus also needs a new gamestate obj and new player objs
-    shared_ptr<Player> tempWhite = make_shared<Player>(WHITE);
-    shared_ptr<Player> tempBlack = make_shared<Player>(BLACK);
-    shared_ptr<Player> tempNull = make_shared<Player>(RGBColor{-1, -1, -1});
-    shared_ptr<Board> tempBoard = make_shared<Board>(DEFAULT_TILE_COLOR_, tempNull);
-    shared_ptr<GameState> tempGamestate = make_shared<GameState>(tempWhite, tempBlack, tempBoard);
-    shared_ptr<Player> tempOwner;
-    // bring the new board up to date
-    // oldboard = the board before this hypothetical move
-    for (shared_ptr<Disc> piece : oldBoard->getAllPieces()) {
-        TilePoint thisPiecePos = piece->getPos();
-        if (piece->getColor().isEqualTo(WHITE)) {
-            tempOwner = tempWhite;
+    }
+    
+    // the first (expected best) move is searched on its own, so the others start with its score as their bound
+    searchRootMove_(*threads_[0], root, searchOrder[0]);
+    root.unfinished--;
+    root.firstDone = true;
+    signalWork_();
+    helperLoop_(*threads_[0], root);
+    if (threadPool_)
+        threadPool_->wait();
+    
+    bestInd = root.bestInd;
+    pv = root.pv;
+    return root.bestScore;
+}
+
+
+void AiMind::helperLoop_(SearchThread& t, RootSearch& root) {
+    idleThreads_++;
+    while (true) {
+        // read before looking for work, so work offered after the look still wakes this thread
+        uint64_t epoch = workEpoch_.load();
+        if (root.unfinished == 0)
+            break;
+        // root moves first, then any split point that still has moves left
+        if (root.firstDone && (root.nextMove < root.searchOrder.size())) {
+            unsigned int k = root.nextMove++;
+            if (k < root.searchOrder.size()) {
+                idleThreads_--;
+                searchRootMove_(t, root, root.searchOrder[k]);
+                root.unfinished--;
+                idleThreads_++;
+                signalWork_(); // the last root move lets everyone out
+            }
+        } else if (SplitPoint* sp = trySteal_(nullptr)) {
+            idleThreads_--;
+            helpSplit_(t, *sp);
+            idleThreads_++;
         } else {
-            tempOwner = tempBlack;
+            waitForWork_(epoch);
+        }
+    }
+    idleThreads_--;
+}
+
+
+void AiMind::signalWork_() {
+    {
+        std::lock_guard<std::mutex> lock(workMutex_);
+        workEpoch_++;
+    }
+    workAvailable_.notify_all();
+}
+
+
+void AiMind::waitForWork_(uint64_t epoch) {
+    std::unique_lock<std::mutex> lock(workMutex_);
+    workAvailable_.wait(lock, [this, epoch] { return workEpoch_.load() != epoch; });
+}
+
+
+bool AiMind::stopped_(const SearchThread& t) const {
+    if (searchAborted_.load(std::memory_order_relaxed))
+        return true;
+    for (const SplitPoint* sp = t.activeSplit; sp; sp = sp->parent) {
+        if (sp->cancelled.load(std::memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+
+
+void AiMind::splitSearch_(SearchThread& t, unsigned int depth, Side aiSide, int& alpha, int beta, int& bestScore, int& bestMove, const ScoredMove* moves, unsigned int numMoves) {
+    unsigned int ply = t.ply();
+    SplitPoint sp;
+    sp.parent = t.activeSplit;
+    sp.pos = t.pos;
+    sp.hash = t.hash;
+    sp.evalState = t.evalState;
+    sp.ply = ply;
+    sp.depth = depth;
+    sp.aiSide = aiSide;
+    std::copy(moves, moves + numMoves, sp.moves);
+    sp.numMoves = numMoves;
+    sp.beta = beta;
+    sp.alpha = alpha;
+    sp.bestScore = bestScore;
+    sp.bestMove = bestMove;
+    std::copy(&t.pvTable[ply][ply], &t.pvTable[ply][0] + t.pvLength[ply], &sp.pv[ply]);
+    sp.pvLength = t.pvLength[ply];
+    
+    {
+        std::lock_guard<std::mutex> lock(t.splitsMutex);
+        t.splits.push_back(&sp);
+    }
+    signalWork_();
+    t.activeSplit = &sp;
+    searchSplitMoves_(t, sp);
+    t.activeSplit = sp.parent;
+    {
+        std::lock_guard<std::mutex> lock(t.splitsMutex);
+        t.splits.pop_back();
+    }
+    
+    // no one can join any more; while the helpers finish their moves, help them with the split points below this one
+    while (true) {
+        uint64_t epoch = workEpoch_.load();
+        if (sp.helpers == 0)
+            break;
+        if (SplitPoint* below = trySteal_(&sp))
+            helpSplit_(t, *below);
+        else
+            waitForWork_(epoch);
+    }
+    
+    std::lock_guard<std::mutex> lock(sp.mutex);
+    alpha = sp.alpha;
+    bestScore = sp.bestScore;
+    bestMove = sp.bestMove;
+    std::copy(&sp.pv[ply], &sp.pv[0] + sp.pvLength, &t.pvTable[ply][ply]);
+    t.pvLength[ply] = sp.pvLength;
+}
+
+
+void AiMind::searchSplitMoves_(SearchThread& t, SplitPoint& sp) {
+    unsigned int ply = sp.ply;
+    Side mover = sp.pos.toMove;
+    while (!stopped_(t)) {
+        unsigned int m = sp.nextMove++;
+        if (m >= sp.numMoves)
+            break;
+        int sq = sp.moves[m].square;
+        int alpha;
+        {
+            std::lock_guard<std::mutex> lock(sp.mutex);
+            alpha = sp.alpha;
+        }
+        
+        makeMove_(t, mover, sq);
+        int score = -negamax_(t, sp.depth - 1, sp.aiSide, -alpha - 1, -alpha);
+        if ((score > alpha) && (score < sp.beta) && !stopped_(t))
+            score = -negamax_(t, sp.depth - 1, sp.aiSide, -sp.beta, -alpha);
+        unmakeMove_(t);
+        if (stopped_(t))
+            break;
+        
+        std::lock_guard<std::mutex> lock(sp.mutex);
+        if (score > sp.bestScore) {
+            sp.bestScore = score;
+            sp.bestMove = sq;
+            if (score > sp.alpha) {
+                sp.alpha = score;
+                sp.pv[ply] = sq;
+                std::copy(&t.pvTable[ply + 1][ply + 1], &t.pvTable[ply + 1][0] + t.pvLength[ply + 1], &sp.pv[ply + 1]);
+                sp.pvLength = std::max(t.pvLength[ply + 1], ply + 1);
+            }
+        }
+        if (sp.alpha >= sp.beta) {
+            // the first move is index 0 at this node, the shared ones start at 1
+            t.orderer.recordCutoff(mover, sq, ply, sp.depth, m + 1);
+            countCutoff_(t, ply, m + 1);
+            sp.cancelled = true;
+            break;
         }
-        tempGamestate->addGamePiece(thisPiecePos, tempOwner);
     }
-    TilePoint thisMoveLoc = thisMove->getPos();
-    shared_ptr<Tile> hypMove = tempBoard->getBoardTile(thisMoveLoc);
+}
+
+
+void AiMind::helpSplit_(SearchThread& t, SplitPoint& sp) {
+    PROFILE_ZONE("AiMind::helpSplit");
+    // search from the split point's position, on top of whatever this thread was doing
+    Position savedPos = t.pos;
+    uint64_t savedHash = t.hash;
+    EvalState savedEvalState = t.evalState;
+    int savedPlyBase = t.plyBase;
+    SplitPoint* savedSplit = t.activeSplit;
+    
+    t.pos = sp.pos;
+    t.hash = sp.hash;
+    t.evalState = sp.evalState;
+    t.plyBase = (int)sp.ply - (int)t.undoStack.size();
+    t.activeSplit = &sp;
+    searchSplitMoves_(t, sp);
     
-    // the maximizing player (AI) is black
-    if (maxing) {
-        tempOwner = tempBlack;
+    t.pos = savedPos;
+    t.hash = savedHash;
+    t.evalState = savedEvalState;
+    t.plyBase = savedPlyBase;
+    t.activeSplit = savedSplit;
+    sp.helpers--;
+    signalWork_(); // the owner may be waiting for its last helper
+}
+
+
+AiMind::SplitPoint* AiMind::trySteal_(const SplitPoint* within) {
+    for (auto& owner : threads_) {
+        std::lock_guard<std::mutex> lock(owner->splitsMutex);
+        // oldest first: the split point nearest the root has the most work left under it
+        for (SplitPoint* sp : owner->splits) {
+            if (sp->cancelled || (sp->nextMove >= sp->numMoves))
+                continue;
+            if (within) {
+                const SplitPoint* ancestor = sp->parent;
+                while (ancestor && (ancestor != within)) {
+                    ancestor = ancestor->parent;
+                }
+                if (!ancestor)
+                    continue;
+            }
+            // joined while the owner still lists it, so it can't go away before this thread leaves
+            sp->helpers++;
+            return sp;
+        }
+    }
+    return nullptr;
+}
+
+
+void AiMind::searchRootMove_(SearchThread& t, RootSearch& root, unsigned int i) {
+    PROFILE_ZONE("AiMind::searchRootMove");
+    if (searchAborted_ || root.failedHigh)
+        return;
+    
+    // search against the best score any thread has found so far
+    bool first;
+    int alpha;
+    unsigned int bestInd;
+    {
+        std::lock_guard<std::mutex> lock(root.mutex);
+        first = !root.haveBest;
+        alpha = first ? root.alpha : std::max(root.alpha, root.bestScore);
+        bestInd = root.bestInd;
+    }
+    int beta = root.beta;
+    
+    makeMove_(t, root.aiSide, root.rootMoves[i]);
+    int score;
+    if (first) {
+        score = -negamax_(t, root.depth, root.aiSide, -beta, -alpha);
     } else {
-        tempOwner = tempWhite;
+        // moves that come before the current best in possibleMoves only need to tie it, so ties go to the move listed first
+        int moveAlpha = (i < bestInd) ? alpha - 1 : alpha;
+        score = -negamax_(t, root.depth, root.aiSide, -moveAlpha - 1, -moveAlpha);
+        if ((score > moveAlpha) && (score < beta) && !stopped_(t))
+            score = -negamax_(t, root.depth, root.aiSide, -beta, -moveAlpha);
     }
-    tempGamestate->placePiece(tempOwner, hypMove);
+    unmakeMove_(t);
+    if (searchAborted_)
+        return;
     
-    return minimax(!maxing, depth - 1, tempBlack, tempWhite, tempBoard, tempGamestate, alpha, beta);
+    // the best may have improved since this move started, but a score that only beat an older bound is still compared exactly here
+    std::lock_guard<std::mutex> lock(root.mutex);
+    root.moveScores[i] = score;
+    if (!root.haveBest || (score > root.bestScore) || ((score == root.bestScore) && (i < root.bestInd))) {
+        root.haveBest = true;
+        root.bestScore = score;
+        root.bestInd = i;
+        root.pv.assign(1, root.rootMoves[i]);
+        root.pv.insert(root.pv.end(), &t.pvTable[1][1], &t.pvTable[1][0] + t.pvLength[1]);
+    }
+    if (score >= beta)
+        root.failedHigh = true; // outside the aspiration window, the caller will widen it
+}
+
+
+int AiMind::evalPosition(const Position& pos, Side forWho) {
+    if (evaluator_ == Evaluator::PATTERNS)
+        return patternEval_.evaluate(pos, forWho);
+    return evalWeights_(pos, forWho);
 }
 
 
-int AiMind::evalGamestateScore(shared_ptr<Player>& forWho, shared_ptr<GameState>& layout) {
+void AiMind::evalPositions(const Position* positions, size_t count, int* scores) {
+    if (evaluator_ == Evaluator::PATTERNS) {
+        patternEval_.evaluateBatch(positions, count, scores);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        scores[i] = evalWeights_(positions[i], positions[i].toMove);
+    }
+}
+
+
+int AiMind::evalWeights_(const Position& pos, Side forWho) {
     unsigned int numDiscs, mobility, stability, cornerPieces, cornerAdj, frontiers;
     GamestateScore curScore;
+    Bitboard myDiscs = pos.discs[forWho];
+    Bitboard blank = pos.emptySquares();
     
     /// Find number of discs I control
-    std::vector<std::vector<std::shared_ptr<Tile>>> myTiles;
-    numDiscs = layout->getPlayerTiles(forWho, myTiles);
+    numDiscs = popCount(myDiscs);
     
     /// Find my mobility (number of possible moves)
-    std::vector<std::shared_ptr<Tile>> possibleMoves;
-    layout->getPlayableTiles(forWho, possibleMoves);
-    mobility = (int)possibleMoves.size();
-    
-    /// Calculate stability and count corner pieces
-    std::vector<std::vector<std::shared_ptr<Tile>>> allMyPieces;  // tiles where I currently have pieces placed
-    layout->getPlayerTiles(forWho, allMyPieces); // populate my tiles
-    cornerPieces = 0;
-    cornerAdj = 0;
-    stability = 0;
+    mobility = popCount(pos.legalMoves(forWho));
+    
+    /// Count corner & corner-adjacent pieces
+    cornerPieces = popCount(myDiscs & CORNER_SQUARES);
+    cornerAdj = popCount(myDiscs & CORNER_ADJ_SQUARES);
+    
+    /// Stable discs are the ones no sequence of moves can flip
+    stability = popCount(stableDiscs(pos, forWho));
+    
+    /// Count blank tiles next to each of my discs (one shift per direction counts every disc's neighbor in that direction)
     frontiers = 0;
-    for (unsigned int r = 0; r < allMyPieces.size(); r++) {
-        for (unsigned int c = 0; c < allMyPieces[r].size(); c++) {
-            std::shared_ptr<Tile> thisTile = allMyPieces[r][c];
-            if (layout->isCornerTile(thisTile)) // if the tile is a corner piece
-                cornerPieces++;
-            if (layout->isCornerAdj(thisTile))
-                cornerAdj++;
-            if (layout->discIsStable(thisTile)) // if the tile isn't flankable by the opponent
-                stability++;
-            frontiers += layout->numFrontierTiles(thisTile);
-        }
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        frontiers += popCount(shiftDir(myDiscs, d) & blank);
     }
+    
     /// Multiply by weights and sum products together
     curScore.mobilityScore = mobility * MOBILITY_WEIGHT_;
     curScore.cornerControlScore = cornerPieces * CORNER_WEIGHT_;
@@ -151,47 +852,135 @@ int AiMind::evalGamestateScore(shared_ptr<Player>& forWho, shared_ptr<GameState>
 }
 
 
-unsigned int AiMind::bestMoveMinimax(shared_ptr<Player>& aiPlayer, shared_ptr<Board>& mainGameBoard, shared_ptr<GameState>& mainGameState, vector<shared_ptr<Tile>>& possibleMoves, unsigned int depth) {
+unsigned int AiMind::bestMove(const Position& pos, const std::vector<int>& rootMoves, const SearchLimits& limits) {
+    PROFILE_ZONE("AiMind::bestMove");
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    
+    // each search thread works on its own copy, which every move below is made on & taken back from
+    Side aiSide = pos.toMove;
+    rootPos_ = pos;
+    rootHash_ = searchHashOf(rootPos_, aiSide);
+    transTable_.newSearch();
+    for (auto& t : threads_) {
+        resetThread_(*t, rootPos_, rootHash_);
+        t->orderer.newSearch();
+        t->nodes = 0;
+        t->leafEvals = 0;
+        std::fill(std::begin(t->plyStats), std::end(t->plyStats), PlyStats{0, 0, 0});
+    }
+    
+    sharedNodes_ = 0;
+    nodeLimit_ = limits.maxNodes;
+    hasDeadline_ = limits.maxSeconds > 0;
+    deadline_ = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(limits.maxSeconds));
+    stopFlag_ = limits.stopFlag;
+    iterationsDone_ = 0;
+    progressBestMove_ = NO_SQUARE;
+    searchAborted_ = stopFlag_ && stopFlag_->load();
+    lastSearch_ = SearchInfo{0, 0, {}, 0, 0, {}, false, false, {}, false, 0, {}, TTStats{}};
+    
+    // known opening theory: no search at all
+    unsigned int bookInd = 0;
+    if (!searchAborted_ && probeBook_(rootMoves, bookInd)) {
+        stopFlag_ = nullptr;
+        lastSearch_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return bookInd;
+    }
+    
+    // close enough to the end to play perfectly; if the solver runs out of time, search as usual with what's left
+    unsigned int solvedInd = 0;
+    if (!searchAborted_ && solveEndgame_(rootMoves, limits, startTime, solvedInd)) {
+        stopFlag_ = nullptr;
+        lastSearch_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return solvedInd;
+    }
+    
+    // no point searching past the end of the game: the root move + 'depth' more moves can't exceed the blank squares
+    unsigned int maxDepth = limits.maxDepth;
+    int empties = rootPos_.numEmpties();
+    if (empties >= 1 && maxDepth > (unsigned int)(empties - 1))
+        maxDepth = empties - 1;
+    
+    // the order root moves are searched in: starts in possibleMoves order, then best-first by the last finished iteration's scores
+    std::vector<unsigned int> searchOrder(rootMoves.size());
+    std::iota(searchOrder.begin(), searchOrder.end(), 0);
+    std::vector<int> moveScores(rootMoves.size(), -SCORE_INFINITY);
+    
     unsigned int bestMoveInd = 0;
-    int bestMoveScore = 0;
-    int curMoveScore = 0;
-    for (unsigned int i = 0; i < possibleMoves.size(); i++) {
-        shared_ptr<Tile> thisMove = possibleMoves[i];
+    int prevScore = 0;
+    uint64_t prevIterNodes = 0;
+    for (unsigned int depth = 0; depth <= maxDepth && !rootMoves.empty(); depth++) {
+        // the first iteration always finishes, so there's always a move to play
+        canAbort_ = depth > 0;
+        std::chrono::steady_clock::time_point iterStart = std::chrono::steady_clock::now();
+        PROFILE_ZONE("AiMind::bestMove iteration");
         
-        shared_ptr<Player> tempWhite = make_shared<Player>(WHITE);
-        shared_ptr<Player> tempBlack = make_shared<Player>(BLACK);
-        shared_ptr<Player> tempNull = make_shared<Player>(RGBColor{-1, -1, -1});
-        shared_ptr<Board> tempBoard = make_shared<Board>(DEFAULT_TILE_COLOR_, tempNull);
-        shared_ptr<GameState> tempGamestate = make_shared<GameState>(tempWhite, tempBlack, tempBoard);
-        shared_ptr<Player> tempOwner;
-        // bring the new board up to date
-        // thisboard = the board before this hypothetical move
-        for (shared_ptr<Disc> piece : mainGameBoard->getAllPieces()) {
-            TilePoint thisPiecePos = piece->getPos();
-            if (piece->getColor().isEqualTo(WHITE)) {
-                tempOwner = tempWhite;
+        // aspiration window: expect about the same score as last iteration, and widen the window if the search falls outside it
+        int delta = ASPIRATION_WINDOW_;
+        int alpha = (depth == 0) ? -SCORE_INFINITY : std::max(prevScore - delta, -SCORE_INFINITY);
+        int beta = (depth == 0) ? SCORE_INFINITY : std::min(prevScore + delta, SCORE_INFINITY);
+        unsigned int iterBestInd = searchOrder[0];
+        int iterScore = 0;
+        std::vector<int> iterScores(rootMoves.size(), -SCORE_INFINITY);
+        std::vector<int> iterPv;
+        while (true) {
+            iterBestInd = searchOrder[0];
+            iterScore = searchRoot_(aiSide, rootMoves, searchOrder, iterScores, depth, alpha, beta, iterBestInd, iterPv);
+            if (searchAborted_)
+                break;
+            if ((iterScore <= alpha) && (alpha > -SCORE_INFINITY)) {
+                alpha = std::max(alpha - delta, -SCORE_INFINITY);
+            } else if ((iterScore >= beta) && (beta < SCORE_INFINITY)) {
+                beta = std::min(beta + delta, SCORE_INFINITY);
             } else {
-                tempOwner = tempBlack;
+                break;
             }
-            tempGamestate->addGamePiece(thisPiecePos, tempOwner);
+            delta *= 2;
         }
-        TilePoint thisMoveLoc = thisMove->getPos();
-        shared_ptr<Tile> hypMove = tempBoard->getBoardTile(thisMoveLoc);
-        tempGamestate->placePiece(tempBlack, hypMove);
+        if (searchAborted_)
+            break; // unfinished iteration, keep the last finished one's move
         
-        // applying minimax to this hypothetical move will give us the overall score for this move
-        if (aiPlayer->getMyColor().isEqualTo(BLACK)) {
-            // AI is in black's perspective, white is the opponent
-            curMoveScore = minimax(false, depth, tempBlack, tempWhite, tempBoard, tempGamestate, INT_MIN, INT_MAX);
-        } else {
-            // AI is in white's perspective, black is the opponent
-            curMoveScore = minimax(false, depth, tempWhite, tempBlack, tempBoard, tempGamestate, INT_MIN, INT_MAX);
-        }
-        if (curMoveScore > bestMoveScore) {
-            bestMoveInd = i;
-            bestMoveScore = curMoveScore;
+        bestMoveInd = iterBestInd;
+        prevScore = iterScore;
+        moveScores = iterScores;
+        lastSearch_.depthReached = depth;
+        lastSearch_.score = iterScore;
+        lastSearch_.principalVariation = iterPv;
+        iterationsDone_ = depth + 1;
+        progressBestMove_ = rootMoves[bestMoveInd];
+        
+        // every thread is done with this iteration, so their node counts can be read
+        uint64_t iterNodes = 0;
+        for (auto& t : threads_) {
+            iterNodes += t->nodes;
         }
+        double iterSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - iterStart).count();
+        lastSearch_.iterations.push_back(IterationInfo{depth, iterNodes - prevIterNodes, iterSeconds, iterScore});
+        prevIterNodes = iterNodes;
+        
+        // best move first, the rest by their (upper bound) scores
+        std::stable_sort(searchOrder.begin(), searchOrder.end(), [&moveScores, bestMoveInd](unsigned int a, unsigned int b) {
+            if ((a == bestMoveInd) != (b == bestMoveInd))
+                return a == bestMoveInd;
+            return moveScores[a] > moveScores[b];
+        });
+        
+        // the next iteration takes at least as long as this one did, so don't start one that can't finish
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if (hasDeadline_ && (elapsed * 2 > limits.maxSeconds))
+            break;
+    }
     
+    for (auto& t : threads_) {
+        lastSearch_.nodes += t->nodes;
+        lastSearch_.threadNodes.push_back(t->nodes);
+        lastSearch_.table += t->ttStats;
     }
+    collectThreadStats_();
+    if (searchStats_)
+        collectSearchStats_();
+    stopFlag_ = nullptr;
+    lastSearch_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    canAbort_ = false;
     return bestMoveInd;
 }
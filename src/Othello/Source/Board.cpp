@@ -20,6 +20,11 @@ const int Board::Y_MAX_ = 8 + PADDING_;
 const float Board::WIDTH_ = (ROWS_MAX_ + PADDING_) - (ROWS_MIN_ - PADDING_);
 const float Board::HEIGHT_ = (COLS_MAX_ + PADDING_) - (COLS_MIN_ - PADDING_);
 
+// set by setScalingRatios once the window size is known
+float Board::pixelToWorldRatio;
+float Board::worldToPixelRatio;
+float Board::drawInPixelScale;
+
 
 Board::Board(RGBColor tileColor, std::shared_ptr<Player>& nullplayerRef)
     :   Object(0, 0, 0),
@@ -0,0 +1,65 @@
+//
+//  BookBuilder.cpp
+//  Othello
+//
+
+#include "BookBuilder.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+using namespace othello;
+
+
+std::vector<BookEntry> othello::buildOpeningBook(AiMind& ai, unsigned int plies, unsigned int depth, std::ostream* log) {
+    std::vector<BookEntry> entries;
+
+    // one pass per color the AI can play, breadth-first by ply
+    for (Side aiSide : {SIDE_BLACK, SIDE_WHITE}) {
+        std::unordered_set<uint64_t> seen;
+        std::vector<Position> current = {Position::initial()};
+        for (unsigned int ply = 0; (ply < plies) && !current.empty(); ply++) {
+            std::vector<Position> next;
+            for (Position pos : current) {
+                Bitboard moves = pos.legalMoves();
+                if (moves == 0) {
+                    pos.pass();
+                    moves = pos.legalMoves();
+                    if (moves == 0)
+                        continue; // game over already
+                }
+
+                int symmetry;
+                uint64_t key = OpeningBook::canonicalKey(pos, symmetry);
+                if ((key == 0) || !seen.insert(key).second)
+                    continue; // same as a position already in the book (or already expanded)
+
+                if (pos.toMove != aiSide) {
+                    // the opponent's turn: the AI has to be ready for any reply
+                    while (moves) {
+                        Position child = pos;
+                        child.play(popLowestSquare(moves));
+                        next.push_back(child);
+                    }
+                    continue;
+                }
+
+                std::vector<int> rootMoves;
+                while (moves) {
+                    rootMoves.push_back(popLowestSquare(moves));
+                }
+                unsigned int bestInd = ai.bestMove(pos, rootMoves, SearchLimits{depth, 0, 0});
+                const SearchInfo& info = ai.getLastSearchInfo();
+                int score = std::max(-32768, std::min(32767, info.score));
+                entries.push_back(BookEntry{key, (int16_t)score, (uint8_t)OpeningBook::transformSquare(rootMoves[bestInd], symmetry), (uint8_t)info.depthReached, 0});
+
+                Position child = pos;
+                child.play(rootMoves[bestInd]);
+                next.push_back(child);
+            }
+            current = std::move(next);
+            if (log)
+                *log << "AI as " << (aiSide == SIDE_BLACK ? "black" : "white") << ", ply " << ply + 1 << ": " << entries.size() << " positions" << std::endl;
+        }
+    }
+    return entries;
+}
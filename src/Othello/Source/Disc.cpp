@@ -6,6 +6,7 @@
 //
 
 #include "Disc.hpp"
+#include <cmath>
 
 using namespace othello;
 
@@ -0,0 +1,418 @@
+//
+//  EndgameSolver.cpp
+//  Othello
+//
+
+#include "EndgameSolver.hpp"
+#include "Zobrist.hpp"
+#include "MoveOrdering.hpp"
+#include "Stability.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+
+using namespace othello;
+
+
+const int EndgameSolver::MIN_TABLE_EMPTIES_ = 7;
+const int EndgameSolver::FASTEST_FIRST_EMPTIES_ = 8;
+
+// no final disc difference is bigger than this
+static const int MAX_SCORE = NUM_SQUARES;
+
+// how many nodes to search between looks at the clock & stop flag
+static const uint64_t NODES_BETWEEN_LIMIT_CHECKS = 4096;
+
+/// Empty squares in regions with an odd number of empties (the quadrants: the last move in a region is usually worth having).
+static Bitboard oddRegions(Bitboard empties) {
+    Bitboard odd = 0;
+    for (Bitboard quadrant : QUADRANTS) {
+        if (popCount(empties & quadrant) & 1)
+            odd |= quadrant;
+    }
+    return empties & odd;
+}
+
+
+EndgameSolver::EndgameSolver(size_t tableMB)
+    :   table_(tableMB, ReplacementPolicy::TWO_TIER),
+        tableStats_(TTStats{}),
+        hash_(0),
+        nodes_(0),
+        stopFlag_(nullptr),
+        hasDeadline_(false),
+        stopped_(false)
+{
+}
+
+
+void EndgameSolver::countNode_() {
+    nodes_++;
+    if ((nodes_ % NODES_BETWEEN_LIMIT_CHECKS) != 0)
+        return;
+    if (stopFlag_ && stopFlag_->load(std::memory_order_relaxed))
+        stopped_ = true;
+    if (hasDeadline_ && (std::chrono::steady_clock::now() >= deadline_))
+        stopped_ = true;
+}
+
+
+void EndgameSolver::makeMove_(Position& pos, int sq, MoveUndo& undo) {
+    undo = pos.makeMove(sq);
+    hash_ ^= zobrist::moveDelta(undo);
+}
+
+
+void EndgameSolver::unmakeMove_(Position& pos, const MoveUndo& undo) {
+    hash_ ^= zobrist::moveDelta(undo);
+    pos.unmakeMove(undo);
+}
+
+
+void EndgameSolver::pass_(Position& pos) {
+    pos.pass();
+    hash_ ^= zobrist::whiteToMoveKey();
+}
+
+
+int EndgameSolver::finalScore_(const Position& pos) const {
+    int mine = pos.count(pos.toMove);
+    int theirs = pos.count(opponentOf(pos.toMove));
+    int empties = NUM_SQUARES - mine - theirs;
+    if (mine > theirs)
+        return mine - theirs + empties;
+    if (mine < theirs)
+        return mine - theirs - empties;
+    return 0;
+}
+
+
+int EndgameSolver::stabilityBound_(const Position& pos) const {
+    return MAX_SCORE - 2 * popCount(stableDiscs(pos, opponentOf(pos.toMove)));
+}
+
+
+int EndgameSolver::solveLast1_(const Position& pos, int sq) const {
+    Side mover = pos.toMove;
+    int diff = pos.count(mover) - pos.count(opponentOf(mover));
+
+    int flipped = popCount(pos.flips(mover, sq));
+    if (flipped)
+        return diff + 1 + 2 * flipped;
+
+    // the side to move has to pass, the opponent may still take the last square
+    flipped = popCount(pos.flips(opponentOf(mover), sq));
+    if (flipped)
+        return diff - 1 - 2 * flipped;
+
+    // nobody can move there: the empty square goes to the winner
+    return (diff > 0) ? diff + 1 : (diff < 0) ? diff - 1 : 0;
+}
+
+
+/// Plays 'sq' for the side to move, whose flips are already known to be 'flipped' (non-empty).
+static MoveUndo playFlips(Position& pos, int sq, Bitboard flipped) {
+    Side mover = pos.toMove;
+    pos.discs[mover] |= flipped | squareBit(sq);
+    pos.discs[opponentOf(mover)] &= ~flipped;
+    pos.toMove = opponentOf(mover);
+    return MoveUndo{sq, flipped, mover};
+}
+
+
+int EndgameSolver::solveLast2_(Position& pos, int sq1, int sq2, int alpha, int beta, bool passed) {
+    countNode_();
+    Side mover = pos.toMove;
+    int bestScore = -MAX_SCORE - 1;
+    if (Bitboard flipped = pos.flips(mover, sq1)) {
+        MoveUndo undo = playFlips(pos, sq1, flipped);
+        bestScore = -solveLast1_(pos, sq2);
+        pos.unmakeMove(undo);
+        if (bestScore >= beta)
+            return bestScore;
+    }
+    if (Bitboard flipped = pos.flips(mover, sq2)) {
+        MoveUndo undo = playFlips(pos, sq2, flipped);
+        bestScore = std::max(bestScore, -solveLast1_(pos, sq1));
+        pos.unmakeMove(undo);
+    }
+    if (bestScore != -MAX_SCORE - 1)
+        return bestScore;
+
+    // no move: the game is over if the opponent couldn't move either, otherwise they move again
+    if (passed)
+        return finalScore_(pos);
+    pos.pass();
+    int score = -solveLast2_(pos, sq1, sq2, -beta, -alpha, true);
+    pos.pass();
+    return score;
+}
+
+
+int EndgameSolver::solveLast3_(Position& pos, int sq1, int sq2, int sq3, int alpha, int beta, bool passed) {
+    countNode_();
+    Side mover = pos.toMove;
+    const int squares[3] = {sq1, sq2, sq3};
+    int bestScore = -MAX_SCORE - 1;
+    for (int i = 0; i < 3; i++) {
+        Bitboard flipped = pos.flips(mover, squares[i]);
+        if (!flipped)
+            continue;
+        MoveUndo undo = playFlips(pos, squares[i], flipped);
+        // the other two, in their original order
+        int score = -solveLast2_(pos, squares[i == 0 ? 1 : 0], squares[i == 2 ? 1 : 2], -beta, -std::max(alpha, bestScore), false);
+        pos.unmakeMove(undo);
+        if (score > bestScore) {
+            bestScore = score;
+            if (bestScore >= beta)
+                return bestScore;
+        }
+    }
+    if (bestScore != -MAX_SCORE - 1)
+        return bestScore;
+
+    if (passed)
+        return finalScore_(pos);
+    pos.pass();
+    int score = -solveLast3_(pos, sq1, sq2, sq3, -beta, -alpha, true);
+    pos.pass();
+    return score;
+}
+
+
+int EndgameSolver::solveLast4_(Position& pos, int sq1, int sq2, int sq3, int sq4, int alpha, int beta, bool passed) {
+    countNode_();
+    Side mover = pos.toMove;
+    const int squares[4] = {sq1, sq2, sq3, sq4};
+    int bestScore = -MAX_SCORE - 1;
+    for (int i = 0; i < 4; i++) {
+        Bitboard flipped = pos.flips(mover, squares[i]);
+        if (!flipped)
+            continue;
+        int rest[3];
+        for (int j = 0, k = 0; j < 4; j++) {
+            if (j != i)
+                rest[k++] = squares[j];
+        }
+        MoveUndo undo = playFlips(pos, squares[i], flipped);
+        int score = -solveLast3_(pos, rest[0], rest[1], rest[2], -beta, -std::max(alpha, bestScore), false);
+        pos.unmakeMove(undo);
+        if (score > bestScore) {
+            bestScore = score;
+            if (bestScore >= beta)
+                return bestScore;
+        }
+    }
+    if (bestScore != -MAX_SCORE - 1)
+        return bestScore;
+
+    if (passed)
+        return finalScore_(pos);
+    pos.pass();
+    int score = -solveLast4_(pos, sq1, sq2, sq3, sq4, -beta, -alpha, true);
+    pos.pass();
+    return score;
+}
+
+
+int EndgameSolver::searchSmall_(Position& pos, Bitboard empties, int alpha, int beta, bool passed) {
+    if (stopped_)
+        return 0;
+
+    // odd regions first; small nodes aren't hashed, so hash_ isn't updated below here
+    int squares[SMALL_KERNEL_EMPTIES_ - 1];
+    int numSquares = 0;
+    Bitboard odd = oddRegions(empties);
+    for (Bitboard group : {odd, empties & ~odd}) {
+        while (group) {
+            squares[numSquares++] = popLowestSquare(group);
+        }
+    }
+    switch (numSquares) {
+        case 0:
+            // the root's move filled the board
+            countNode_();
+            return finalScore_(pos);
+        case 1:
+            countNode_();
+            return solveLast1_(pos, squares[0]);
+        case 2:
+            return solveLast2_(pos, squares[0], squares[1], alpha, beta, passed);
+        case 3:
+            return solveLast3_(pos, squares[0], squares[1], squares[2], alpha, beta, passed);
+        default:
+            return solveLast4_(pos, squares[0], squares[1], squares[2], squares[3], alpha, beta, passed);
+    }
+}
+
+
+int EndgameSolver::search_(Position& pos, Bitboard empties, int alpha, int beta, bool passed) {
+    int numEmpties = popCount(empties);
+    if (numEmpties < SMALL_KERNEL_EMPTIES_)
+        return searchSmall_(pos, empties, alpha, beta, passed);
+
+    countNode_();
+    if (stopped_)
+        return 0;
+
+    // stability cutoff: the opponent keeps their stable discs whatever happens, which caps our score
+    Side mover = pos.toMove;
+    if (alpha >= MAX_SCORE - 2 * pos.count(opponentOf(mover))) {
+        int bound = stabilityBound_(pos);
+        if (bound <= alpha)
+            return bound;
+    }
+
+    int alphaOrig = alpha, betaOrig = beta;
+    int hashMove = NO_SQUARE;
+    bool useTable = numEmpties >= MIN_TABLE_EMPTIES_;
+    if (useTable) {
+        // a position's empties never change, so every stored entry was searched to the end of the game
+        TTEntry entry;
+        if (table_.probe(hash_, entry, tableStats_)) {
+            hashMove = entry.bestMove;
+            if (entry.bound == BoundType::EXACT)
+                return entry.score;
+            if (entry.bound == BoundType::LOWER)
+                alpha = std::max(alpha, (int)entry.score);
+            else if (entry.bound == BoundType::UPPER)
+                beta = std::min(beta, (int)entry.score);
+            if (beta <= alpha)
+                return entry.score;
+        }
+    }
+
+    Bitboard moves = pos.legalMoves();
+    if (moves == 0) {
+        if (passed)
+            return finalScore_(pos);
+        pass_(pos);
+        int score = -search_(pos, empties, -beta, -alpha, true);
+        pass_(pos);
+        return score;
+    }
+
+    // fastest first: the moves leaving the opponent the fewest replies (their corners count double), odd regions as a tie-break
+    ScoredMove orderedMoves[NUM_SQUARES];
+    unsigned int numMoves = 0;
+    Bitboard odd = oddRegions(empties);
+    bool fastestFirst = numEmpties >= FASTEST_FIRST_EMPTIES_;
+    while (moves) {
+        int sq = popLowestSquare(moves);
+        int score;
+        if (sq == hashMove) {
+            score = 1 << 20;
+        } else if (fastestFirst) {
+            MoveUndo undo = pos.makeMove(sq);
+            Bitboard replies = pos.legalMoves();
+            Bitboard frontier = neighborsOf(pos.emptySquares()) & pos.discs[mover];
+            pos.unmakeMove(undo);
+            score = -16 * (popCount(replies) + popCount(replies & CORNER_SQUARES)) - 2 * popCount(frontier);
+            if (odd & squareBit(sq))
+                score += 4;
+        } else {
+            score = (odd & squareBit(sq)) ? 4 : 0;
+        }
+        unsigned int i = numMoves++;
+        while ((i > 0) && (orderedMoves[i - 1].score < score)) {
+            orderedMoves[i] = orderedMoves[i - 1];
+            i--;
+        }
+        orderedMoves[i] = ScoredMove{sq, score};
+    }
+
+    int bestScore = -MAX_SCORE - 1;
+    int bestMove = NO_SQUARE;
+    for (unsigned int m = 0; m < numMoves; m++) {
+        int sq = orderedMoves[m].square;
+        MoveUndo undo;
+        makeMove_(pos, sq, undo);
+        Bitboard childEmpties = empties & ~squareBit(sq);
+        int score;
+        if (m == 0) {
+            score = -search_(pos, childEmpties, -beta, -alpha, false);
+        } else {
+            score = -search_(pos, childEmpties, -alpha - 1, -alpha, false);
+            if ((score > alpha) && (score < beta) && !stopped_)
+                score = -search_(pos, childEmpties, -beta, -alpha, false);
+        }
+        unmakeMove_(pos, undo);
+        if (stopped_)
+            return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = sq;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+
+    if (useTable) {
+        BoundType bound = BoundType::EXACT;
+        if (bestScore <= alphaOrig)
+            bound = BoundType::UPPER;
+        else if (bestScore >= betaOrig)
+            bound = BoundType::LOWER;
+        table_.store(hash_, numEmpties, bound, bestScore, bestMove, tableStats_);
+    }
+    return bestScore;
+}
+
+
+bool EndgameSolver::solve(const Position& pos, const std::vector<int>& rootMoves, SolveMode mode, EndgameResult& result) {
+    PROFILE_ZONE("EndgameSolver::solve");
+    Position searchPos = pos;
+    Bitboard empties = searchPos.emptySquares();
+    hash_ = zobrist::hashOf(searchPos);
+    nodes_ = 0;
+    stopped_ = false;
+    table_.newSearch();
+
+    // MTD(f): null-window tests home in on the score, each one reusing the bounds the table kept from the last
+    // (a null window cuts off far more than a full one). Win/loss/draw only needs the tests around 0.
+    int lower = -MAX_SCORE, upper = MAX_SCORE;
+    int guess = 0;
+    while (lower < upper) {
+        int beta = (guess == lower) ? guess + 1 : guess;
+        guess = search_(searchPos, empties, beta - 1, beta, false);
+        if (stopped_)
+            return false;
+        if (guess < beta)
+            upper = guess;
+        else
+            lower = guess;
+        if ((mode == SolveMode::WIN_LOSS_DRAW) && ((lower > 0) || (upper < 0) || ((lower == 0) && (upper == 0))))
+            break;
+    }
+    // win/loss/draw stops with only a bound: at least 'lower' for a win, at most 'upper' for a loss
+    int score = lower;
+    if ((mode == SolveMode::WIN_LOSS_DRAW) && (lower <= 0))
+        score = (upper < 0) ? upper : 0;
+
+    // the best move is the first listed one reaching the score (the table makes these tests cheap). A lost position's score is only
+    // an upper bound that no move may reach; then every move loses, and the one with the highest bound is played
+    unsigned int bestInd = 0;
+    int bestBound = -MAX_SCORE - 1;
+    for (unsigned int i = 0; i < rootMoves.size(); i++) {
+        MoveUndo undo;
+        makeMove_(searchPos, rootMoves[i], undo);
+        int moveScore = -search_(searchPos, empties & ~squareBit(rootMoves[i]), -score, -score + 1, false);
+        unmakeMove_(searchPos, undo);
+        if (stopped_)
+            return false;
+        if (moveScore >= score) {
+            bestInd = i;
+            break;
+        }
+        if (moveScore > bestBound) {
+            bestBound = moveScore;
+            bestInd = i;
+        }
+    }
+
+    result = EndgameResult{score, rootMoves[bestInd], nodes_};
+    return true;
+}
@@ -0,0 +1,128 @@
+//
+//  MoveOrdering.cpp
+//  Othello
+//
+
+#include "MoveOrdering.hpp"
+
+using namespace othello;
+
+
+const unsigned int MoveOrderer::OPPONENT_MOBILITY_MIN_DEPTH_ = 3;
+
+// corners are the best squares on the board, X-squares (diagonally next to a corner) the worst since they give the corner away
+const int MoveOrderer::SQUARE_PRIORITY_[NUM_SQUARES] = {
+    100, -20,  10,   5,   5,  10, -20, 100,
+    -20, -50,  -2,  -2,  -2,  -2, -50, -20,
+     10,  -2,   1,   1,   1,   1,  -2,  10,
+      5,  -2,   1,   0,   0,   1,  -2,   5,
+      5,  -2,   1,   0,   0,   1,  -2,   5,
+     10,  -2,   1,   1,   1,   1,  -2,  10,
+    -20, -50,  -2,  -2,  -2,  -2, -50, -20,
+    100, -20,  10,   5,   5,  10, -20, 100
+};
+
+// priorities for moves found by the hash move & killer stages, well above anything the other stages can add up to
+static const int HASH_MOVE_PRIORITY = 1 << 30;
+static const int KILLER_PRIORITY[2] = {1 << 29, 1 << 28};
+
+// history scores are kept below this, so they never outrank a killer
+static const int MAX_HISTORY = 1 << 20;
+
+// how much one reply the opponent gets is worth, compared to the square priorities
+static const int OPPONENT_MOVE_PENALTY = 15;
+
+
+MoveOrderer::MoveOrderer()
+    :   stages_(ORDER_ALL),
+        stats_(OrderingStats{})
+{
+    clear();
+}
+
+
+void MoveOrderer::newSearch() {
+    for (unsigned int p = 0; p < MAX_PLY_; p++) {
+        killers_[p][0] = killers_[p][1] = NO_SQUARE;
+    }
+    for (int s = 0; s < 2; s++) {
+        for (int sq = 0; sq < NUM_SQUARES; sq++) {
+            history_[s][sq] /= 2;
+        }
+    }
+}
+
+
+void MoveOrderer::clear() {
+    for (unsigned int p = 0; p < MAX_PLY_; p++) {
+        killers_[p][0] = killers_[p][1] = NO_SQUARE;
+    }
+    for (int s = 0; s < 2; s++) {
+        for (int sq = 0; sq < NUM_SQUARES; sq++) {
+            history_[s][sq] = 0;
+        }
+    }
+}
+
+
+unsigned int MoveOrderer::orderMoves(const Position& pos, Side mover, Bitboard moves, int hashMove, unsigned int ply, unsigned int depth, ScoredMove* out) {
+    stats_.nodes++;
+    bool useMobility = (stages_ & ORDER_OPPONENT_MOBILITY) && (depth >= OPPONENT_MOBILITY_MIN_DEPTH_);
+    const int* killers = (ply < MAX_PLY_) ? killers_[ply] : nullptr;
+
+    unsigned int numMoves = 0;
+    while (moves) {
+        int sq = popLowestSquare(moves);
+        int score = 0;
+
+        if ((stages_ & ORDER_HASH_MOVE) && (sq == hashMove)) {
+            score += HASH_MOVE_PRIORITY;
+        } else if ((stages_ & ORDER_KILLERS) && killers && (sq == killers[0])) {
+            score += KILLER_PRIORITY[0];
+        } else if ((stages_ & ORDER_KILLERS) && killers && (sq == killers[1])) {
+            score += KILLER_PRIORITY[1];
+        }
+        if (stages_ & ORDER_HISTORY)
+            score += history_[mover][sq];
+        if (stages_ & ORDER_SQUARE_PRIORITY)
+            score += SQUARE_PRIORITY_[sq];
+        if (useMobility) {
+            Position next = pos;
+            next.toMove = mover;
+            next.play(sq);
+            score -= OPPONENT_MOVE_PENALTY * popCount(next.legalMoves(opponentOf(mover)));
+        }
+
+        // insertion sort, best first (there are rarely more than a dozen moves)
+        unsigned int i = numMoves++;
+        while ((i > 0) && (out[i - 1].score < score)) {
+            out[i] = out[i - 1];
+            i--;
+        }
+        out[i] = ScoredMove{sq, score};
+    }
+    return numMoves;
+}
+
+
+void MoveOrderer::recordCutoff(Side mover, int sq, unsigned int ply, unsigned int depth, unsigned int moveIndex) {
+    stats_.cutoffs++;
+    stats_.cutoffIndexSum += moveIndex;
+    if (moveIndex == 0)
+        stats_.firstMoveCutoffs++;
+
+    if ((ply < MAX_PLY_) && (killers_[ply][0] != sq)) {
+        killers_[ply][1] = killers_[ply][0];
+        killers_[ply][0] = sq;
+    }
+
+    // deeper cutoffs saved more work, so they count for more
+    history_[mover][sq] += depth * depth;
+    if (history_[mover][sq] > MAX_HISTORY) {
+        for (int s = 0; s < 2; s++) {
+            for (int i = 0; i < NUM_SQUARES; i++) {
+                history_[s][i] /= 2;
+            }
+        }
+    }
+}
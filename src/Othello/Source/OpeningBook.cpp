@@ -0,0 +1,228 @@
+//
+//  OpeningBook.cpp
+//  Othello
+//
+
+#include "OpeningBook.hpp"
+#include "Zobrist.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace othello;
+
+
+static const char BOOK_MAGIC[8] = {'O', 'T', 'H', 'B', 'O', 'O', 'K', '\0'};
+static const uint32_t BOOK_VERSION = 1;
+
+static_assert(sizeof(BookHeader) == 32, "book files are read in place, so the header layout must not change");
+static_assert(sizeof(BookEntry) == 16, "book files are read in place, so the entry layout must not change");
+
+
+/// Mirrors the board top to bottom (y -> 9 - y).
+static Bitboard flipVertical(Bitboard b) {
+    return __builtin_bswap64(b);
+}
+
+
+/// Mirrors the board left to right (x -> 9 - x).
+static Bitboard mirrorHorizontal(Bitboard b) {
+    const Bitboard k1 = 0x5555555555555555ULL, k2 = 0x3333333333333333ULL, k4 = 0x0F0F0F0F0F0F0F0FULL;
+    b = ((b >> 1) & k1) | ((b & k1) << 1);
+    b = ((b >> 2) & k2) | ((b & k2) << 2);
+    b = ((b >> 4) & k4) | ((b & k4) << 4);
+    return b;
+}
+
+
+/// Swaps x & y (mirrors the board across the diagonal through squares 0 and 63).
+static Bitboard transpose(Bitboard b) {
+    const Bitboard k1 = 0x5500550055005500ULL, k2 = 0x3333000033330000ULL, k4 = 0x0F0F0F0F00000000ULL;
+    Bitboard t = k4 & (b ^ (b << 28));
+    b ^= t ^ (t >> 28);
+    t = k2 & (b ^ (b << 14));
+    b ^= t ^ (t >> 14);
+    t = k1 & (b ^ (b << 7));
+    b ^= t ^ (t >> 7);
+    return b;
+}
+
+
+OpeningBook::OpeningBook()
+    :   data_(nullptr),
+        size_(0),
+        header_(nullptr),
+        entries_(nullptr)
+{
+}
+
+
+OpeningBook::~OpeningBook() {
+    close();
+}
+
+
+bool OpeningBook::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    // no mmap: read the file in one go instead (still no parsing)
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if ((fstat(fd, &info) != 0) || (info.st_size < (off_t)sizeof(BookHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping stays valid without the descriptor
+    if (mapped == MAP_FAILED)
+        return false;
+    data_ = (const unsigned char*)mapped;
+    size_ = (size_t)info.st_size;
+#endif
+
+    // the only checks: is it a book, and does its size match the table it claims to hold
+    const BookHeader* header = (const BookHeader*)data_;
+    bool valid = (size_ >= sizeof(BookHeader)) &&
+                 (memcmp(header->magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) == 0) &&
+                 (header->version == BOOK_VERSION) &&
+                 (header->entrySize == sizeof(BookEntry)) &&
+                 (header->numSlots > 0) && ((header->numSlots & (header->numSlots - 1)) == 0) &&
+                 (header->numEntries < header->numSlots) &&
+                 (size_ == sizeof(BookHeader) + header->numSlots * sizeof(BookEntry));
+    if (!valid) {
+        close();
+        return false;
+    }
+    header_ = header;
+    entries_ = (const BookEntry*)(data_ + sizeof(BookHeader));
+    return true;
+}
+
+
+void OpeningBook::close() {
+#ifdef _WIN32
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+#else
+    if (data_)
+        munmap((void*)data_, size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    entries_ = nullptr;
+}
+
+
+bool OpeningBook::lookup(const Position& pos, BookMove& out) const {
+    if (!header_)
+        return false;
+    int symmetry;
+    uint64_t key = canonicalKey(pos, symmetry);
+    if (key == 0)
+        return false;
+
+    // linear probing; the table is never full, so every probe sequence ends at an empty slot
+    uint64_t mask = header_->numSlots - 1;
+    for (uint64_t i = key & mask; entries_[i].key != 0; i = (i + 1) & mask) {
+        if (entries_[i].key != key)
+            continue;
+        // the move is stored for the canonical position: find the square that symmetry maps onto it
+        for (int sq = 0; sq < NUM_SQUARES; sq++) {
+            if (transformSquare(sq, symmetry) == entries_[i].move) {
+                out = BookMove{sq, entries_[i].score, entries_[i].depth};
+                return true;
+            }
+        }
+        return false;
+    }
+    return false;
+}
+
+
+uint64_t OpeningBook::canonicalKey(const Position& pos, int& symmetry) {
+    uint64_t best = 0;
+    for (int s = 0; s < 8; s++) {
+        Position transformed = pos;
+        transformed.discs[SIDE_BLACK] = transformBitboard(pos.discs[SIDE_BLACK], s);
+        transformed.discs[SIDE_WHITE] = transformBitboard(pos.discs[SIDE_WHITE], s);
+        uint64_t key = zobrist::hashOf(transformed);
+        if ((s == 0) || (key < best)) {
+            best = key;
+            symmetry = s;
+        }
+    }
+    return best;
+}
+
+
+int OpeningBook::transformSquare(int sq, int symmetry) {
+    int x = sq & 7, y = sq >> 3;
+    if (symmetry & 4)
+        std::swap(x, y);
+    if (symmetry & 1)
+        x = 7 - x;
+    if (symmetry & 2)
+        y = 7 - y;
+    return y * 8 + x;
+}
+
+
+Bitboard OpeningBook::transformBitboard(Bitboard b, int symmetry) {
+    // same order as transformSquare
+    if (symmetry & 4)
+        b = transpose(b);
+    if (symmetry & 1)
+        b = mirrorHorizontal(b);
+    if (symmetry & 2)
+        b = flipVertical(b);
+    return b;
+}
+
+
+bool OpeningBook::write(const std::string& path, const std::vector<BookEntry>& entries) {
+    // at most half full, so probe sequences stay short
+    uint64_t numSlots = 1;
+    while (numSlots < 2 * (entries.size() + 1)) {
+        numSlots *= 2;
+    }
+    std::vector<BookEntry> table(numSlots, BookEntry{0, 0, 0, 0, 0});
+    for (const BookEntry& entry : entries) {
+        uint64_t i = entry.key & (numSlots - 1);
+        while (table[i].key != 0) {
+            i = (i + 1) & (numSlots - 1);
+        }
+        table[i] = entry;
+    }
+
+    BookHeader header;
+    memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    header.version = BOOK_VERSION;
+    header.entrySize = sizeof(BookEntry);
+    header.numSlots = numSlots;
+    header.numEntries = entries.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)table.data(), (std::streamsize)(table.size() * sizeof(BookEntry)));
+    return (bool)out;
+}
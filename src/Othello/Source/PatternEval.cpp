@@ -0,0 +1,685 @@
+//
+//  PatternEval.cpp
+//  Othello
+//
+
+#include "PatternEval.hpp"
+#include "Stability.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// the vector batch paths are x86-64 only; elsewhere (e.g. Apple silicon) evaluateBatch() always takes the scalar path
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PATTERN_EVAL_SIMD 1
+#include <immintrin.h>
+#endif
+
+using namespace othello;
+
+
+namespace {
+    /// Most squares in any pattern type.
+    constexpr unsigned int MAX_PATTERN_SQUARES = 10;
+
+    /// One place a pattern type sits on the board.
+    struct PatternInstance {
+        PatternType type;
+        unsigned int numSquares;
+
+        /// Squares in the order their digits are read (most significant first), so every instance of a type indexes its table alike.
+        int squares[MAX_PATTERN_SQUARES];
+
+        /// Where its type's table starts within a phase's tables.
+        unsigned int tableOffset;
+    };
+
+    /// A pattern type as it sits in the top-left corner: its squares (x, y from 0) in digit order.
+    struct BasePattern {
+        unsigned int numSquares;
+        int x[MAX_PATTERN_SQUARES];
+        int y[MAX_PATTERN_SQUARES];
+    };
+
+    /// Each pattern type's base pattern. The other instances are its rotations & reflections.
+    constexpr BasePattern BASE_PATTERNS[NUM_PATTERN_TYPES] = {
+        // PATTERN_EDGE_2X: the top edge, then the X-squares (B2, G2)
+        {10, {0, 1, 2, 3, 4, 5, 6, 7, 1, 6}, {0, 0, 0, 0, 0, 0, 0, 0, 1, 1}},
+        // PATTERN_CORNER_3X3: row by row, the corner first
+        {9, {0, 1, 2, 0, 1, 2, 0, 1, 2}, {0, 0, 0, 1, 1, 1, 2, 2, 2}},
+        // PATTERN_CORNER_2X5
+        {10, {0, 1, 2, 3, 4, 0, 1, 2, 3, 4}, {0, 0, 0, 0, 0, 1, 1, 1, 1, 1}},
+        // PATTERN_DIAG_8 down to PATTERN_DIAG_4
+        {8, {0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7}},
+        {7, {0, 1, 2, 3, 4, 5, 6}, {1, 2, 3, 4, 5, 6, 7}},
+        {6, {0, 1, 2, 3, 4, 5}, {2, 3, 4, 5, 6, 7}},
+        {5, {0, 1, 2, 3, 4}, {3, 4, 5, 6, 7}},
+        {4, {0, 1, 2, 3}, {4, 5, 6, 7}}
+    };
+
+    /// Number of symmetries of the board: bit 2 transposes, bit 0 mirrors x, bit 1 mirrors y.
+    constexpr int NUM_SYMMETRIES = 8;
+
+    /// Square digit k of pattern type t lands on under 'symmetry'.
+    constexpr int instanceSquare(unsigned int t, unsigned int k, int symmetry) {
+        int x = BASE_PATTERNS[t].x[k], y = BASE_PATTERNS[t].y[k];
+        if (symmetry & 4) {
+            int swapped = x;
+            x = y;
+            y = swapped;
+        }
+        if (symmetry & 1)
+            x = 7 - x;
+        if (symmetry & 2)
+            y = 7 - y;
+        return y * 8 + x;
+    }
+
+    constexpr Bitboard instanceMask(unsigned int t, int symmetry) {
+        Bitboard mask = 0;
+        for (unsigned int k = 0; k < BASE_PATTERNS[t].numSquares; k++) {
+            mask |= squareBit(instanceSquare(t, k, symmetry));
+        }
+        return mask;
+    }
+
+    /// Whether a symmetry of type t is an instance of its own: symmetric patterns (edges, diagonals) cover the same squares under
+    /// several symmetries, and only the first of them is kept.
+    constexpr bool isDistinctInstance(unsigned int t, int symmetry) {
+        for (int earlier = 0; earlier < symmetry; earlier++) {
+            if (instanceMask(t, earlier) == instanceMask(t, symmetry))
+                return false;
+        }
+        return true;
+    }
+
+    constexpr unsigned int countInstances() {
+        unsigned int count = 0;
+        for (unsigned int t = 0; t < NUM_PATTERN_TYPES; t++) {
+            for (int symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++) {
+                count += isDistinctInstance(t, symmetry);
+            }
+        }
+        return count;
+    }
+
+    /// Most pattern instances any one square is part of.
+    constexpr unsigned int maxInstancesPerSquare() {
+        unsigned int perSquare[NUM_SQUARES] = {};
+        for (unsigned int t = 0; t < NUM_PATTERN_TYPES; t++) {
+            for (int symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++) {
+                if (!isDistinctInstance(t, symmetry))
+                    continue;
+                for (unsigned int k = 0; k < BASE_PATTERNS[t].numSquares; k++) {
+                    perSquare[instanceSquare(t, k, symmetry)]++;
+                }
+            }
+        }
+        unsigned int most = 0;
+        for (unsigned int count : perSquare) {
+            most = std::max(most, count);
+        }
+        return most;
+    }
+
+    // EvalState & the evaluation loops are sized by the header's count, which has to match the patterns above
+    static_assert(countInstances() == NUM_PATTERN_INSTANCES, "NUM_PATTERN_INSTANCES doesn't match the pattern set");
+
+    /// Where each type's table starts within a phase, and how many entries all of a phase's tables hold.
+    struct TableLayout {
+        unsigned int offset[NUM_PATTERN_TYPES];
+        unsigned int size[NUM_PATTERN_TYPES];
+        unsigned int configsPerPhase;
+
+        TableLayout() {
+            configsPerPhase = 0;
+            for (unsigned int t = 0; t < NUM_PATTERN_TYPES; t++) {
+                size[t] = 1;
+                for (unsigned int k = 0; k < BASE_PATTERNS[t].numSquares; k++) {
+                    size[t] *= 3;
+                }
+                offset[t] = configsPerPhase;
+                configsPerPhase += size[t];
+            }
+        }
+    };
+
+    const TableLayout LAYOUT;
+
+    /// Extra entry after the last table: a gather reads 32 bits per 16-bit entry, so reading the last one would otherwise run past the end.
+    const size_t TABLE_PADDING = 1;
+
+    /// Every distinct rotation & reflection of every base pattern.
+    std::vector<PatternInstance> makeInstances() {
+        std::vector<PatternInstance> instances;
+        for (unsigned int t = 0; t < NUM_PATTERN_TYPES; t++) {
+            for (int symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++) {
+                if (!isDistinctInstance(t, symmetry))
+                    continue;
+                PatternInstance inst;
+                inst.type = (PatternType)t;
+                inst.numSquares = BASE_PATTERNS[t].numSquares;
+                inst.tableOffset = LAYOUT.offset[t];
+                for (unsigned int k = 0; k < inst.numSquares; k++) {
+                    inst.squares[k] = instanceSquare(t, k, symmetry);
+                }
+                instances.push_back(inst);
+            }
+        }
+        return instances;
+    }
+
+    const std::vector<PatternInstance> INSTANCES = makeInstances();
+
+    /// Most pattern instances any one square is part of.
+    constexpr unsigned int MAX_INSTANCES_PER_SQUARE = maxInstancesPerSquare();
+
+    /// For each square, the instances it's part of and what a disc of the evaluated side there adds to their index (3^digit position);
+    /// an opponent disc adds twice as much.
+    struct SquareContributions {
+        unsigned int count;
+        unsigned int instance[MAX_INSTANCES_PER_SQUARE];
+        unsigned int weight[MAX_INSTANCES_PER_SQUARE];
+    };
+
+    struct ContributionTable {
+        SquareContributions squares[NUM_SQUARES];
+
+        ContributionTable() {
+            for (int sq = 0; sq < NUM_SQUARES; sq++) {
+                squares[sq].count = 0;
+            }
+            for (unsigned int i = 0; i < INSTANCES.size(); i++) {
+                unsigned int weight = 1;
+                for (int k = (int)INSTANCES[i].numSquares - 1; k >= 0; k--, weight *= 3) {
+                    SquareContributions& c = squares[INSTANCES[i].squares[k]];
+                    c.instance[c.count] = i;
+                    c.weight[c.count] = weight;
+                    c.count++;
+                }
+            }
+        }
+    };
+
+    const ContributionTable CONTRIBUTIONS;
+
+    /// Digits of a configuration: 0 = empty, 1 = mine, 2 = theirs.
+    const int EMPTY = 0, MINE = 1, THEIRS = 2;
+
+    /// +1 for my disc, -1 for theirs, 0 for empty.
+    inline int ownership(int digit) {
+        return (digit == MINE) ? 1 : ((digit == THEIRS) ? -1 : 0);
+    }
+
+    /// Stability difference of the 6 inner squares of an edge (digits 0-7 of PATTERN_EDGE_2X); the corners are scored by PATTERN_CORNER_3X3.
+    /// A disc is stable along the edge when the edge is full, or when a run of its own color joins it to a corner.
+    int edgeStability(const int* d) {
+        bool full = true;
+        for (int k = 0; k < 8; k++) {
+            full &= (d[k] != EMPTY);
+        }
+        int stable = 0;
+        for (int k = 1; k < 7; k++) {
+            if (d[k] == EMPTY)
+                continue;
+            bool joined = full;
+            for (int corner : {0, 7}) {
+                bool run = true;
+                for (int j = std::min(corner, k); j <= std::max(corner, k); j++) {
+                    run &= (d[j] == d[k]);
+                }
+                joined |= run;
+            }
+            if (joined)
+                stable += ownership(d[k]);
+        }
+        return stable;
+    }
+
+    /// Score of the features outside the tables, for the side owning 'mine'. 'myMoves' & 'theirMoves' are both sides' legal moves,
+    /// and 'nextToEmpty' the squares next to an empty one.
+    inline int featureScore(const PhaseWeights& w, Bitboard mine, Bitboard theirs, Bitboard myMoves, Bitboard theirMoves, Bitboard nextToEmpty) {
+        int score = w.disc * (popCount(mine) - popCount(theirs));
+        score += w.mobility * (popCount(myMoves) - popCount(theirMoves));
+        score += w.frontier * (popCount(mine & nextToEmpty) - popCount(theirs & nextToEmpty));
+        score += w.stability * (popCount(stableDiscs(mine, theirs) & INNER_SQUARES) - popCount(stableDiscs(theirs, mine) & INNER_SQUARES));
+        return score;
+    }
+
+#ifdef PATTERN_EVAL_SIMD
+    /// Positions per block on each vector path.
+    const unsigned int AVX2_LANES = 8;
+    const unsigned int AVX512_LANES = 16;
+
+    /// A block of positions laid out for the vector code, which reads each lane's discs (as seen by its side to move) and table start
+    /// and writes its pattern sum & bitboard features back; the rest of the score is then added up lane by lane.
+    template <unsigned int LANES>
+    struct BatchBlock {
+        alignas(64) Bitboard mine[LANES];
+        alignas(64) Bitboard theirs[LANES];
+        /// The same discs as 32-bit halves (low, high), so a pattern index fits a 32-bit lane.
+        alignas(64) uint32_t mineHalves[2][LANES];
+        alignas(64) uint32_t theirsHalves[2][LANES];
+        /// Where the position's phase's tables start.
+        alignas(64) int32_t tableBase[LANES];
+        unsigned int phase[LANES];
+
+        alignas(64) int32_t patterns[LANES];
+        alignas(64) Bitboard myMoves[LANES];
+        alignas(64) Bitboard theirMoves[LANES];
+        alignas(64) Bitboard nextToEmpty[LANES];
+
+        inline void load(const Position* positions) {
+            for (unsigned int j = 0; j < LANES; j++) {
+                const Position& pos = positions[j];
+                mine[j] = pos.discs[pos.toMove];
+                theirs[j] = pos.discs[opponentOf(pos.toMove)];
+                mineHalves[0][j] = (uint32_t)mine[j];
+                mineHalves[1][j] = (uint32_t)(mine[j] >> 32);
+                theirsHalves[0][j] = (uint32_t)theirs[j];
+                theirsHalves[1][j] = (uint32_t)(theirs[j] >> 32);
+                phase[j] = PatternEvaluator::phaseOf(pos.numEmpties());
+                tableBase[j] = (int32_t)(phase[j] * LAYOUT.configsPerPhase);
+            }
+        }
+
+        inline void finish(const PhaseWeights* weights, int* scores) const {
+            for (unsigned int j = 0; j < LANES; j++) {
+                scores[j] = patterns[j] + featureScore(weights[phase[j]], mine[j], theirs[j], myMoves[j], theirMoves[j], nextToEmpty[j]);
+            }
+        }
+    };
+
+    /// Runs 'evaluateBlock' over every whole block of 'positions', then over the rest padded out with copies of the last position.
+    template <unsigned int LANES>
+    void evaluateInBlocks(void (*evaluateBlock)(const int16_t*, const PhaseWeights*, const Position*, int*), const int16_t* tables, const PhaseWeights* weights,
+                          const Position* positions, size_t count, int* scores) {
+        size_t i = 0;
+        for (; i + LANES <= count; i += LANES) {
+            evaluateBlock(tables, weights, positions + i, scores + i);
+        }
+        if (i < count) {
+            Position rest[LANES];
+            int restScores[LANES];
+            for (size_t j = 0; j < LANES; j++) {
+                rest[j] = positions[std::min(i + j, count - 1)];
+            }
+            evaluateBlock(tables, weights, rest, restScores);
+            std::copy(restScores, restScores + (count - i), scores + i);
+        }
+    }
+
+    // AVX2: pattern indices 8 positions to a register (32-bit lanes), bitboard features 4 to a register (64-bit lanes)
+
+    __attribute__((target("avx2")))
+    inline __m256i shiftUpAvx2(__m256i b, int shift) {
+        return _mm256_sll_epi64(b, _mm_cvtsi32_si128(shift));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i shiftDownAvx2(__m256i b, int shift) {
+        return _mm256_srl_epi64(b, _mm_cvtsi32_si128(shift));
+    }
+
+    /// Moves of 'mine' along the lines in both directions of 'shift', over runs of the 'flippable' discs.
+    __attribute__((target("avx2")))
+    inline __m256i lineMovesAvx2(__m256i mine, __m256i flippable, int shift) {
+        __m256i up = _mm256_and_si256(shiftUpAvx2(mine, shift), flippable);
+        __m256i down = _mm256_and_si256(shiftDownAvx2(mine, shift), flippable);
+        for (int i = 0; i < 5; i++) {
+            up = _mm256_or_si256(up, _mm256_and_si256(shiftUpAvx2(up, shift), flippable));
+            down = _mm256_or_si256(down, _mm256_and_si256(shiftDownAvx2(down, shift), flippable));
+        }
+        return _mm256_or_si256(shiftUpAvx2(up, shift), shiftDownAvx2(down, shift));
+    }
+
+    /// Legal moves of 'mine' against 'theirs' (Position::legalMoves), 4 positions at once.
+    __attribute__((target("avx2")))
+    inline __m256i legalMovesAvx2(__m256i mine, __m256i theirs, __m256i empty) {
+        // off the left & right columns, a run can't wrap around into the next row
+        __m256i inner = _mm256_and_si256(theirs, _mm256_set1_epi64x((long long)(NOT_COLUMN_1 & NOT_COLUMN_8)));
+        __m256i innerDiag = _mm256_and_si256(theirs, _mm256_set1_epi64x((long long)INNER_SQUARES));
+        __m256i moves = _mm256_or_si256(lineMovesAvx2(mine, inner, 1), lineMovesAvx2(mine, theirs, 8));
+        moves = _mm256_or_si256(moves, _mm256_or_si256(lineMovesAvx2(mine, innerDiag, 7), lineMovesAvx2(mine, innerDiag, 9)));
+        return _mm256_and_si256(moves, empty);
+    }
+
+    /// Squares next to any of 'b' (neighborsOf), 4 positions at once.
+    __attribute__((target("avx2")))
+    inline __m256i neighborsAvx2(__m256i b) {
+        __m256i sideways = _mm256_or_si256(_mm256_and_si256(shiftUpAvx2(b, 1), _mm256_set1_epi64x((long long)NOT_COLUMN_1)),
+                                           _mm256_and_si256(shiftDownAvx2(b, 1), _mm256_set1_epi64x((long long)NOT_COLUMN_8)));
+        __m256i row = _mm256_or_si256(sideways, b);
+        return _mm256_or_si256(sideways, _mm256_or_si256(shiftUpAvx2(row, 8), shiftDownAvx2(row, 8)));
+    }
+
+    __attribute__((target("avx2,popcnt")))
+    void evaluateBlockAvx2(const int16_t* tables, const PhaseWeights* weights, const Position* positions, int* scores) {
+        BatchBlock<AVX2_LANES> block;
+        block.load(positions);
+
+        // every square's digit in every lane (0 = empty, 1 = mine, 2 = theirs), then each index is read off them like evaluate()'s
+        const __m256i one = _mm256_set1_epi32(1);
+        __m256i digits[NUM_SQUARES];
+        for (int half = 0; half < 2; half++) {
+            __m256i mine = _mm256_loadu_si256((const __m256i*)block.mineHalves[half]);
+            __m256i theirs = _mm256_loadu_si256((const __m256i*)block.theirsHalves[half]);
+            for (int bit = 0; bit < 32; bit++) {
+                __m256i t = _mm256_and_si256(theirs, one);
+                digits[half * 32 + bit] = _mm256_add_epi32(_mm256_and_si256(mine, one), _mm256_add_epi32(t, t));
+                mine = _mm256_srli_epi32(mine, 1);
+                theirs = _mm256_srli_epi32(theirs, 1);
+            }
+        }
+        const __m256i base = _mm256_loadu_si256((const __m256i*)block.tableBase);
+        __m256i sum = _mm256_setzero_si256();
+        for (const PatternInstance& inst : INSTANCES) {
+            __m256i index = digits[inst.squares[0]];
+            for (unsigned int k = 1; k < inst.numSquares; k++) {
+                index = _mm256_add_epi32(_mm256_add_epi32(index, _mm256_add_epi32(index, index)), digits[inst.squares[k]]);
+            }
+            index = _mm256_add_epi32(index, _mm256_add_epi32(base, _mm256_set1_epi32((int)inst.tableOffset)));
+            // 32 bits are gathered per 16-bit entry: keep the low half, sign-extended
+            __m256i entries = _mm256_i32gather_epi32((const int*)tables, index, 2);
+            sum = _mm256_add_epi32(sum, _mm256_srai_epi32(_mm256_slli_epi32(entries, 16), 16));
+        }
+        _mm256_storeu_si256((__m256i*)block.patterns, sum);
+
+        for (unsigned int j = 0; j < AVX2_LANES; j += 4) {
+            __m256i mine = _mm256_loadu_si256((const __m256i*)(block.mine + j));
+            __m256i theirs = _mm256_loadu_si256((const __m256i*)(block.theirs + j));
+            __m256i empty = _mm256_andnot_si256(_mm256_or_si256(mine, theirs), _mm256_set1_epi64x(-1));
+            _mm256_storeu_si256((__m256i*)(block.myMoves + j), legalMovesAvx2(mine, theirs, empty));
+            _mm256_storeu_si256((__m256i*)(block.theirMoves + j), legalMovesAvx2(theirs, mine, empty));
+            _mm256_storeu_si256((__m256i*)(block.nextToEmpty + j), neighborsAvx2(empty));
+        }
+        block.finish(weights, scores);
+    }
+
+    // AVX-512: the same with twice the lanes
+
+    __attribute__((target("avx512f")))
+    inline __m512i shiftUpAvx512(__m512i b, int shift) {
+        return _mm512_sll_epi64(b, _mm_cvtsi32_si128(shift));
+    }
+
+    __attribute__((target("avx512f")))
+    inline __m512i shiftDownAvx512(__m512i b, int shift) {
+        return _mm512_srl_epi64(b, _mm_cvtsi32_si128(shift));
+    }
+
+    __attribute__((target("avx512f")))
+    inline __m512i lineMovesAvx512(__m512i mine, __m512i flippable, int shift) {
+        __m512i up = _mm512_and_si512(shiftUpAvx512(mine, shift), flippable);
+        __m512i down = _mm512_and_si512(shiftDownAvx512(mine, shift), flippable);
+        for (int i = 0; i < 5; i++) {
+            up = _mm512_or_si512(up, _mm512_and_si512(shiftUpAvx512(up, shift), flippable));
+            down = _mm512_or_si512(down, _mm512_and_si512(shiftDownAvx512(down, shift), flippable));
+        }
+        return _mm512_or_si512(shiftUpAvx512(up, shift), shiftDownAvx512(down, shift));
+    }
+
+    __attribute__((target("avx512f")))
+    inline __m512i legalMovesAvx512(__m512i mine, __m512i theirs, __m512i empty) {
+        __m512i inner = _mm512_and_si512(theirs, _mm512_set1_epi64((long long)(NOT_COLUMN_1 & NOT_COLUMN_8)));
+        __m512i innerDiag = _mm512_and_si512(theirs, _mm512_set1_epi64((long long)INNER_SQUARES));
+        __m512i moves = _mm512_or_si512(lineMovesAvx512(mine, inner, 1), lineMovesAvx512(mine, theirs, 8));
+        moves = _mm512_or_si512(moves, _mm512_or_si512(lineMovesAvx512(mine, innerDiag, 7), lineMovesAvx512(mine, innerDiag, 9)));
+        return _mm512_and_si512(moves, empty);
+    }
+
+    __attribute__((target("avx512f")))
+    inline __m512i neighborsAvx512(__m512i b) {
+        __m512i sideways = _mm512_or_si512(_mm512_and_si512(shiftUpAvx512(b, 1), _mm512_set1_epi64((long long)NOT_COLUMN_1)),
+                                           _mm512_and_si512(shiftDownAvx512(b, 1), _mm512_set1_epi64((long long)NOT_COLUMN_8)));
+        __m512i row = _mm512_or_si512(sideways, b);
+        return _mm512_or_si512(sideways, _mm512_or_si512(shiftUpAvx512(row, 8), shiftDownAvx512(row, 8)));
+    }
+
+    __attribute__((target("avx512f,popcnt")))
+    void evaluateBlockAvx512(const int16_t* tables, const PhaseWeights* weights, const Position* positions, int* scores) {
+        BatchBlock<AVX512_LANES> block;
+        block.load(positions);
+
+        const __m512i one = _mm512_set1_epi32(1);
+        __m512i digits[NUM_SQUARES];
+        for (int half = 0; half < 2; half++) {
+            __m512i mine = _mm512_loadu_si512(block.mineHalves[half]);
+            __m512i theirs = _mm512_loadu_si512(block.theirsHalves[half]);
+            for (int bit = 0; bit < 32; bit++) {
+                __m512i t = _mm512_and_si512(theirs, one);
+                digits[half * 32 + bit] = _mm512_add_epi32(_mm512_and_si512(mine, one), _mm512_add_epi32(t, t));
+                mine = _mm512_srli_epi32(mine, 1);
+                theirs = _mm512_srli_epi32(theirs, 1);
+            }
+        }
+        const __m512i base = _mm512_loadu_si512(block.tableBase);
+        __m512i sum = _mm512_setzero_si512();
+        for (const PatternInstance& inst : INSTANCES) {
+            __m512i index = digits[inst.squares[0]];
+            for (unsigned int k = 1; k < inst.numSquares; k++) {
+                index = _mm512_add_epi32(_mm512_add_epi32(index, _mm512_add_epi32(index, index)), digits[inst.squares[k]]);
+            }
+            index = _mm512_add_epi32(index, _mm512_add_epi32(base, _mm512_set1_epi32((int)inst.tableOffset)));
+            __m512i entries = _mm512_i32gather_epi32(index, (const void*)tables, 2);
+            sum = _mm512_add_epi32(sum, _mm512_srai_epi32(_mm512_slli_epi32(entries, 16), 16));
+        }
+        _mm512_storeu_si512(block.patterns, sum);
+
+        for (unsigned int j = 0; j < AVX512_LANES; j += 8) {
+            __m512i mine = _mm512_loadu_si512(block.mine + j);
+            __m512i theirs = _mm512_loadu_si512(block.theirs + j);
+            __m512i empty = _mm512_andnot_si512(_mm512_or_si512(mine, theirs), _mm512_set1_epi64(-1));
+            _mm512_storeu_si512(block.myMoves + j, legalMovesAvx512(mine, theirs, empty));
+            _mm512_storeu_si512(block.theirMoves + j, legalMovesAvx512(theirs, mine, empty));
+            _mm512_storeu_si512(block.nextToEmpty + j, neighborsAvx512(empty));
+        }
+        block.finish(weights, scores);
+    }
+#endif
+
+    const char EVAL_MAGIC[8] = {'O', 'T', 'H', 'E', 'V', 'A', 'L', '\0'};
+    const uint32_t EVAL_VERSION = 2;
+
+    /// Start of a file written by PatternEvaluator::save(); the phase weights, then the tables, follow it.
+    struct EvalFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t numPhases;
+        uint32_t configsPerPhase;
+        uint32_t reserved;
+    };
+}
+
+
+PatternEvaluator::PatternEvaluator(int discWeight, int mobilityWeight, int stabilityWeight, int cornerWeight, int cornerAdjWeight, int frontierWeight)
+    :   tables_((size_t)NUM_EVAL_PHASES * LAYOUT.configsPerPhase + TABLE_PADDING, 0)
+{
+    seed_(discWeight, mobilityWeight, stabilityWeight, cornerWeight, cornerAdjWeight, frontierWeight);
+}
+
+
+void PatternEvaluator::seed_(int discWeight, int mobilityWeight, int stabilityWeight, int cornerWeight, int cornerAdjWeight, int frontierWeight) {
+    // score every configuration of the tables that have hand weights; the 2x5 corners & diagonals stay at 0 until trained
+    std::vector<int16_t> phaseTables(LAYOUT.configsPerPhase, 0);
+    int d[10];
+    for (unsigned int config = 0; config < LAYOUT.size[PATTERN_CORNER_3X3]; config++) {
+        for (int k = 8, rest = (int)config; k >= 0; k--, rest /= 3) {
+            d[k] = rest % 3;
+        }
+        // a corner is always stable; the squares next to it (B1, A2, B2) are only a liability while it's empty
+        int score = ownership(d[0]) * (cornerWeight + stabilityWeight);
+        if (d[0] == EMPTY)
+            score += (ownership(d[1]) + ownership(d[3]) + ownership(d[4])) * cornerAdjWeight;
+        phaseTables[LAYOUT.offset[PATTERN_CORNER_3X3] + config] = (int16_t)score;
+    }
+    for (unsigned int config = 0; config < LAYOUT.size[PATTERN_EDGE_2X]; config++) {
+        for (int k = 9, rest = (int)config; k >= 0; k--, rest /= 3) {
+            d[k] = rest % 3;
+        }
+        phaseTables[LAYOUT.offset[PATTERN_EDGE_2X] + config] = (int16_t)(edgeStability(d) * stabilityWeight);
+    }
+
+    for (unsigned int phase = 0; phase < NUM_EVAL_PHASES; phase++) {
+        std::copy(phaseTables.begin(), phaseTables.end(), tables_.begin() + (size_t)phase * LAYOUT.configsPerPhase);
+        phaseWeights_[phase] = PhaseWeights{(int16_t)discWeight, (int16_t)mobilityWeight, (int16_t)frontierWeight, (int16_t)stabilityWeight};
+    }
+}
+
+
+int PatternEvaluator::evaluate(const Position& pos, Side forWho) const {
+    EvalState state;
+    initState(pos, state);
+    return evaluate(pos, state, forWho);
+}
+
+
+int PatternEvaluator::evaluate(const Position& pos, const EvalState& state, Side forWho) const {
+    unsigned int phase = phaseOf(pos.numEmpties());
+    const int16_t* tables = tables_.data() + (size_t)phase * LAYOUT.configsPerPhase;
+    const uint32_t* mine = state.discs[forWho];
+    const uint32_t* theirs = state.discs[opponentOf(forWho)];
+
+    int score = 0;
+    for (unsigned int i = 0; i < NUM_PATTERN_INSTANCES; i++) {
+        score += tables[INSTANCES[i].tableOffset + mine[i] + 2 * theirs[i]];
+    }
+
+    // the other features are a few bitboard operations whatever the number of discs, so they're worked out here rather than kept in 'state':
+    // mobility & stability can't be updated from a move's flips, and keeping disc counts or the frontier would cost every make & unmake
+    // a popcount or a neighbour fill to save one at the leaves, which are only about half of the nodes (corners are in the pattern tables already)
+    Side opponent = opponentOf(forWho);
+    return score + featureScore(phaseWeights_[phase], pos.discs[forWho], pos.discs[opponent], pos.legalMoves(forWho), pos.legalMoves(opponent),
+                                neighborsOf(pos.emptySquares()));
+}
+
+
+void PatternEvaluator::evaluateBatch(const Position* positions, size_t count, int* scores) const {
+    evaluateBatch(positions, count, scores, bestBatchPath());
+}
+
+
+void PatternEvaluator::evaluateBatch(const Position* positions, size_t count, int* scores, BatchPath path) const {
+    if (path > bestBatchPath())
+        path = bestBatchPath();
+#ifdef PATTERN_EVAL_SIMD
+    if (path == BatchPath::AVX512) {
+        evaluateInBlocks<AVX512_LANES>(evaluateBlockAvx512, tables_.data(), phaseWeights_, positions, count, scores);
+        return;
+    }
+    if (path == BatchPath::AVX2) {
+        evaluateInBlocks<AVX2_LANES>(evaluateBlockAvx2, tables_.data(), phaseWeights_, positions, count, scores);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; i++) {
+        scores[i] = evaluate(positions[i], positions[i].toMove);
+    }
+}
+
+
+BatchPath PatternEvaluator::bestBatchPath() {
+#ifdef PATTERN_EVAL_SIMD
+    static const BatchPath best = __builtin_cpu_supports("avx512f") ? BatchPath::AVX512 :
+                                  (__builtin_cpu_supports("avx2") ? BatchPath::AVX2 : BatchPath::SCALAR);
+    return best;
+#else
+    return BatchPath::SCALAR;
+#endif
+}
+
+
+const char* othello::batchPathName(BatchPath path) {
+    switch (path) {
+        case BatchPath::AVX2:
+            return "AVX2";
+        case BatchPath::AVX512:
+            return "AVX-512";
+        default:
+            return "scalar";
+    }
+}
+
+
+void PatternEvaluator::initState(const Position& pos, EvalState& state) {
+    for (int side = 0; side < 2; side++) {
+        std::fill(state.discs[side], state.discs[side] + NUM_PATTERN_INSTANCES, 0);
+        for (Bitboard b = pos.discs[side]; b; ) {
+            const SquareContributions& c = CONTRIBUTIONS.squares[popLowestSquare(b)];
+            for (unsigned int j = 0; j < c.count; j++) {
+                state.discs[side][c.instance[j]] += c.weight[j];
+            }
+        }
+    }
+}
+
+
+void PatternEvaluator::applyMove(EvalState& state, const MoveUndo& move) {
+    uint32_t* mover = state.discs[move.mover];
+    uint32_t* opponent = state.discs[opponentOf(move.mover)];
+    const SquareContributions& placed = CONTRIBUTIONS.squares[move.square];
+    for (unsigned int j = 0; j < placed.count; j++) {
+        mover[placed.instance[j]] += placed.weight[j];
+    }
+    for (Bitboard b = move.flipped; b; ) {
+        const SquareContributions& c = CONTRIBUTIONS.squares[popLowestSquare(b)];
+        for (unsigned int j = 0; j < c.count; j++) {
+            mover[c.instance[j]] += c.weight[j];
+            opponent[c.instance[j]] -= c.weight[j];
+        }
+    }
+}
+
+
+void PatternEvaluator::undoMove(EvalState& state, const MoveUndo& move) {
+    uint32_t* mover = state.discs[move.mover];
+    uint32_t* opponent = state.discs[opponentOf(move.mover)];
+    const SquareContributions& placed = CONTRIBUTIONS.squares[move.square];
+    for (unsigned int j = 0; j < placed.count; j++) {
+        mover[placed.instance[j]] -= placed.weight[j];
+    }
+    for (Bitboard b = move.flipped; b; ) {
+        const SquareContributions& c = CONTRIBUTIONS.squares[popLowestSquare(b)];
+        for (unsigned int j = 0; j < c.count; j++) {
+            mover[c.instance[j]] -= c.weight[j];
+            opponent[c.instance[j]] += c.weight[j];
+        }
+    }
+}
+
+
+bool PatternEvaluator::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    EvalFileHeader header;
+    if (!in.read((char*)&header, sizeof(header)))
+        return false;
+    if ((memcmp(header.magic, EVAL_MAGIC, sizeof(EVAL_MAGIC)) != 0) || (header.version != EVAL_VERSION) ||
+        (header.numPhases != NUM_EVAL_PHASES) || (header.configsPerPhase != LAYOUT.configsPerPhase))
+        return false;
+
+    PhaseWeights weights[NUM_EVAL_PHASES];
+    std::vector<int16_t> tables(tables_.size(), 0);
+    in.read((char*)weights, sizeof(weights));
+    in.read((char*)tables.data(), (std::streamsize)((tables.size() - TABLE_PADDING) * sizeof(int16_t)));
+    if (!in)
+        return false;
+    std::copy(weights, weights + NUM_EVAL_PHASES, phaseWeights_);
+    tables_ = std::move(tables);
+    return true;
+}
+
+
+bool PatternEvaluator::save(const std::string& path) const {
+    EvalFileHeader header;
+    memcpy(header.magic, EVAL_MAGIC, sizeof(EVAL_MAGIC));
+    header.version = EVAL_VERSION;
+    header.numPhases = NUM_EVAL_PHASES;
+    header.configsPerPhase = LAYOUT.configsPerPhase;
+    header.reserved = 0;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)phaseWeights_, sizeof(phaseWeights_));
+    out.write((const char*)tables_.data(), (std::streamsize)((tables_.size() - TABLE_PADDING) * sizeof(int16_t)));
+    return (bool)out;
+}
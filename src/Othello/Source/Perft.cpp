@@ -0,0 +1,167 @@
+//
+//  Perft.cpp
+//  Othello
+//
+
+#include "Perft.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+using namespace othello;
+
+
+namespace {
+    /// Counts from the initial position (OEIS A124004, also what Edax's perft gives).
+    const std::vector<uint64_t> REFERENCE_COUNTS = {
+        1ULL, 4ULL, 12ULL, 56ULL, 244ULL, 1396ULL, 8200ULL, 55092ULL, 390216ULL, 3005288ULL, 24571284ULL, 212258800ULL,
+        1939886636ULL, 18429641748ULL, 184042084512ULL
+    };
+
+    /// Subtrees with this many plies left or fewer aren't split any further between threads.
+    const unsigned int MIN_SPLIT_DEPTH = 3;
+
+    /// runPerft splits until there are at least this many subtrees per thread, so threads that draw small ones stay busy.
+    const size_t SUBTREES_PER_THREAD = 32;
+
+    template <bool BULK>
+    uint64_t countLeaves(const Position& pos, unsigned int depth) {
+        if (depth == 0)
+            return 1;
+        Bitboard moves = pos.legalMoves();
+        if (moves == 0) {
+            Position passed = pos;
+            passed.pass();
+            if (passed.legalMoves() == 0)
+                return 1; // neither side can move: the game ended here
+            return countLeaves<BULK>(passed, depth - 1);
+        }
+        if (BULK && (depth == 1))
+            return (uint64_t)popCount(moves);
+
+        uint64_t leaves = 0;
+        while (moves) {
+            Position child = pos;
+            child.play(popLowestSquare(moves));
+            leaves += countLeaves<BULK>(child, depth - 1);
+        }
+        return leaves;
+    }
+
+    /// A position still to be counted, and the plies left below it.
+    struct Subtree {
+        Position pos;
+        unsigned int depth;
+    };
+}
+
+
+const std::vector<uint64_t>& othello::perftReferenceCounts() {
+    return REFERENCE_COUNTS;
+}
+
+
+uint64_t othello::perft(const Position& pos, unsigned int depth, bool bulk) {
+    return bulk ? countLeaves<true>(pos, depth) : countLeaves<false>(pos, depth);
+}
+
+
+std::vector<std::pair<int, uint64_t>> othello::perftDivide(const Position& pos, unsigned int depth, bool bulk) {
+    std::vector<std::pair<int, uint64_t>> counts;
+    if (depth == 0)
+        return counts;
+    Bitboard moves = pos.legalMoves();
+    if (moves == 0) {
+        Position passed = pos;
+        passed.pass();
+        counts.emplace_back(NO_SQUARE, (passed.legalMoves() == 0) ? 1 : perft(passed, depth - 1, bulk));
+        return counts;
+    }
+    while (moves) {
+        int sq = popLowestSquare(moves);
+        Position child = pos;
+        child.play(sq);
+        counts.emplace_back(sq, perft(child, depth - 1, bulk));
+    }
+    return counts;
+}
+
+
+PerftResult othello::runPerft(const Position& pos, unsigned int depth, unsigned int numThreads, bool bulk) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    PerftResult result = PerftResult{depth, 0, 0, 0};
+    numThreads = std::max(numThreads, 1u);
+
+    if (numThreads == 1) {
+        result.leaves = perft(pos, depth, bulk);
+    } else {
+        // expand the tree ply by ply until there's enough subtrees to go round; games that end on the way are counted right away
+        std::vector<Subtree> subtrees = {Subtree{pos, depth}};
+        bool expanded = true;
+        while (expanded && (subtrees.size() < SUBTREES_PER_THREAD * numThreads)) {
+            std::vector<Subtree> next;
+            expanded = false;
+            for (const Subtree& subtree : subtrees) {
+                if (subtree.depth <= MIN_SPLIT_DEPTH) {
+                    next.push_back(subtree);
+                    continue;
+                }
+                expanded = true;
+                Bitboard moves = subtree.pos.legalMoves();
+                if (moves == 0) {
+                    Position passed = subtree.pos;
+                    passed.pass();
+                    if (passed.legalMoves() == 0)
+                        result.leaves++;
+                    else
+                        next.push_back(Subtree{passed, subtree.depth - 1});
+                    continue;
+                }
+                while (moves) {
+                    Position child = subtree.pos;
+                    child.play(popLowestSquare(moves));
+                    next.push_back(Subtree{child, subtree.depth - 1});
+                }
+            }
+            subtrees.swap(next);
+        }
+
+        std::vector<uint64_t> workerLeaves(numThreads, 0);
+        {
+            ThreadPool pool(numThreads);
+            for (const Subtree& subtree : subtrees) {
+                pool.submit([&workerLeaves, &subtree, bulk](unsigned int worker) {
+                    workerLeaves[worker] += perft(subtree.pos, subtree.depth, bulk);
+                });
+            }
+            pool.wait();
+        }
+        for (uint64_t leaves : workerLeaves) {
+            result.leaves += leaves;
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.leavesPerSecond = (result.seconds > 0) ? result.leaves / result.seconds : 0;
+    return result;
+}
+
+
+bool othello::validatePerft(unsigned int maxDepth, unsigned int numThreads, std::ostream* log) {
+    bool allMatch = true;
+    maxDepth = std::min(maxDepth, (unsigned int)REFERENCE_COUNTS.size() - 1);
+    for (unsigned int depth = 0; depth <= maxDepth; depth++) {
+        for (bool bulk : {true, false}) {
+            PerftResult result = runPerft(Position::initial(), depth, numThreads, bulk);
+            bool match = (result.leaves == REFERENCE_COUNTS[depth]);
+            allMatch = allMatch && match;
+            if (log) {
+                *log << "depth " << std::setw(2) << depth << (bulk ? "  bulk: " : "  full: ") << std::setw(15) << result.leaves
+                     << (match ? "  ok   " : "  WRONG (expected " + std::to_string(REFERENCE_COUNTS[depth]) + ")  ")
+                     << std::fixed << std::setprecision(3) << result.seconds << "s, " << std::setprecision(0) << result.leavesPerSecond << " leaves/s" << std::endl;
+            }
+        }
+    }
+    return allMatch;
+}
@@ -0,0 +1,368 @@
+//
+//  Position.cpp
+//  Othello
+//
+
+#include "Position.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+
+// the vector move generators are x86-64 only; elsewhere (e.g. Apple silicon) legalMoves() always takes the scalar path
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define POSITION_SIMD 1
+#include <immintrin.h>
+#endif
+
+using namespace othello;
+
+
+// opponent discs a run can go through in each line direction: off the left & right columns (and top & bottom rows for the diagonals),
+// a run ending there would wrap around onto the next row
+static constexpr Bitboard THROUGH_HORIZONTAL = NOT_COLUMN_1 & NOT_COLUMN_8;
+static constexpr Bitboard THROUGH_DIAGONAL = INNER_SQUARES;
+
+
+namespace {
+    /// Shifts towards higher squares by SHIFT, or lower ones by -SHIFT.
+    template <int SHIFT>
+    inline Bitboard shiftBy(Bitboard b) {
+        return (SHIFT > 0) ? (b << (SHIFT & 63)) : (b >> (-SHIFT & 63));
+    }
+
+    /// Squares just past a run of 'through' discs that starts next to one of 'mine', going SHIFT squares at a time.
+    /// The run is grown Kogge-Stone style, doubling the reach each step (1, 2, 4 squares), so 3 steps cover the longest run of 6.
+    template <int SHIFT>
+    inline Bitboard lineMoves(Bitboard mine, Bitboard through) {
+        Bitboard run = shiftBy<SHIFT>(mine) & through;
+        run |= through & shiftBy<SHIFT>(run);
+        through &= shiftBy<SHIFT>(through);
+        run |= through & shiftBy<2 * SHIFT>(run);
+        through &= shiftBy<2 * SHIFT>(through);
+        run |= through & shiftBy<4 * SHIFT>(run);
+        return shiftBy<SHIFT>(run);
+    }
+
+    Bitboard legalMovesScalar(Bitboard mine, Bitboard theirs) {
+        Bitboard horizontal = theirs & THROUGH_HORIZONTAL;
+        Bitboard diagonal = theirs & THROUGH_DIAGONAL;
+        Bitboard moves = lineMoves<1>(mine, horizontal) | lineMoves<-1>(mine, horizontal);
+        moves |= lineMoves<8>(mine, theirs) | lineMoves<-8>(mine, theirs);
+        moves |= lineMoves<9>(mine, diagonal) | lineMoves<-9>(mine, diagonal);
+        moves |= lineMoves<7>(mine, diagonal) | lineMoves<-7>(mine, diagonal);
+        return moves & ~(mine | theirs);
+    }
+
+    /// Tables for Position::flips, worked out at compile time. Each line through a square (its row, column and both diagonals) is read as a byte
+    /// with bit i = the line's square in column i (row i for a column), so a square's place along any of its lines is its x or y, and the same tables serve every line.
+    struct FlipTables {
+        /// For a disc placed at index 'i' of a line whose opponent discs are 'theirs' (line bits 1-6 as bits 0-5; the line's ends can't be flipped,
+        /// so they're left out of the index), the squares just past each run of opponent discs starting next to 'i': one of my discs there outflanks the run.
+        uint8_t outflank[8][64] = {};
+
+        /// For a disc placed at index 'i' and the discs of mine outflanking runs from it, the discs in between (the ones flipped).
+        uint8_t flipped[8][256] = {};
+
+        /// The diagonals through each square: towards higher x & y (steps of 9), and towards lower x & higher y (steps of 7).
+        Bitboard diagonal9[NUM_SQUARES] = {};
+        Bitboard diagonal7[NUM_SQUARES] = {};
+
+        constexpr FlipTables() {
+            for (int i = 0; i < 8; i++) {
+                for (int inner = 0; inner < 64; inner++) {
+                    int theirs = inner << 1;
+                    int out = 0;
+                    for (int dir = -1; dir <= 1; dir += 2) {
+                        int j = i + dir;
+                        while ((j >= 0) && (j < 8) && (theirs & (1 << j))) {
+                            j += dir;
+                        }
+                        if ((j >= 0) && (j < 8) && (j != i + dir))
+                            out |= 1 << j;
+                    }
+                    outflank[i][inner] = (uint8_t)out;
+                }
+                for (int out = 0; out < 256; out++) {
+                    int between = 0;
+                    for (int j = 0; j < 8; j++) {
+                        if (out & (1 << j))
+                            between |= ((1 << std::max(i, j)) - 1) & ~((2 << std::min(i, j)) - 1);
+                    }
+                    flipped[i][out] = (uint8_t)between;
+                }
+            }
+            for (int sq = 0; sq < NUM_SQUARES; sq++) {
+                diagonal9[sq] = RAYS[sq][4] | squareBit(sq) | RAYS[sq][5];
+                diagonal7[sq] = RAYS[sq][6] | squareBit(sq) | RAYS[sq][7];
+            }
+        }
+    };
+
+    constexpr FlipTables FLIP_TABLES;
+
+    /// The squares of 'b' on 'diagonal' as a byte (bit i = the diagonal's square in column i). A diagonal has one square per column,
+    /// so the multiplication stacks them all into the top byte without carries.
+    inline unsigned int diagonalByte(Bitboard b, Bitboard diagonal) {
+        return (unsigned int)(((b & diagonal) * COLUMN_1) >> 56);
+    }
+
+#ifdef POSITION_SIMD
+    // SSE2 (every x86-64 CPU): 2 directions per register. Lane 1 holds the board flipped upside down, so one shift towards higher squares
+    // covers direction +s in lane 0 and its vertical mirror in lane 1 (+8 & -8, +9 & -7, +7 & -9); the horizontal directions have no mirror
+    // pair, so their register is shifted both ways and the lanes recombined.
+
+    /// Lane 0 shifted towards higher squares, lane 1 towards lower ones.
+    template <int SHIFT>
+    inline __m128i shiftBothWaysSse2(__m128i b) {
+        return _mm_castpd_si128(_mm_move_sd(_mm_castsi128_pd(_mm_srli_epi64(b, SHIFT)), _mm_castsi128_pd(_mm_slli_epi64(b, SHIFT))));
+    }
+
+    inline __m128i horizontalMovesSse2(__m128i mine, __m128i through) {
+        __m128i run = _mm_and_si128(shiftBothWaysSse2<1>(mine), through);
+        run = _mm_or_si128(run, _mm_and_si128(through, shiftBothWaysSse2<1>(run)));
+        through = _mm_and_si128(through, shiftBothWaysSse2<1>(through));
+        run = _mm_or_si128(run, _mm_and_si128(through, shiftBothWaysSse2<2>(run)));
+        through = _mm_and_si128(through, shiftBothWaysSse2<2>(through));
+        run = _mm_or_si128(run, _mm_and_si128(through, shiftBothWaysSse2<4>(run)));
+        return shiftBothWaysSse2<1>(run);
+    }
+
+    template <int SHIFT>
+    inline __m128i lineMovesSse2(__m128i mine, __m128i through) {
+        __m128i run = _mm_and_si128(_mm_slli_epi64(mine, SHIFT), through);
+        run = _mm_or_si128(run, _mm_and_si128(through, _mm_slli_epi64(run, SHIFT)));
+        through = _mm_and_si128(through, _mm_slli_epi64(through, SHIFT));
+        run = _mm_or_si128(run, _mm_and_si128(through, _mm_slli_epi64(run, 2 * SHIFT)));
+        through = _mm_and_si128(through, _mm_slli_epi64(through, 2 * SHIFT));
+        run = _mm_or_si128(run, _mm_and_si128(through, _mm_slli_epi64(run, 4 * SHIFT)));
+        return _mm_slli_epi64(run, SHIFT);
+    }
+
+    Bitboard legalMovesSse2(Bitboard mine, Bitboard theirs) {
+        __m128i m = _mm_set_epi64x((long long)__builtin_bswap64(mine), (long long)mine);
+        __m128i t = _mm_set_epi64x((long long)__builtin_bswap64(theirs), (long long)theirs);
+        __m128i diagonal = _mm_and_si128(t, _mm_set1_epi64x((long long)THROUGH_DIAGONAL));
+        __m128i mirrored = _mm_or_si128(_mm_or_si128(lineMovesSse2<8>(m, t), lineMovesSse2<9>(m, diagonal)), lineMovesSse2<7>(m, diagonal));
+        __m128i horizontal = horizontalMovesSse2(_mm_set1_epi64x((long long)mine), _mm_set1_epi64x((long long)(theirs & THROUGH_HORIZONTAL)));
+        Bitboard moves = (Bitboard)_mm_cvtsi128_si64(mirrored) | __builtin_bswap64((Bitboard)_mm_cvtsi128_si64(_mm_unpackhi_epi64(mirrored, mirrored)));
+        moves |= (Bitboard)_mm_cvtsi128_si64(horizontal) | (Bitboard)_mm_cvtsi128_si64(_mm_unpackhi_epi64(horizontal, horizontal));
+        return moves & ~(mine | theirs);
+    }
+
+    // AVX2: the 4 line directions in the lanes of one register, shifted towards higher squares in one copy and lower ones in another
+    // (AVX2 can shift each lane by its own amount)
+
+    __attribute__((target("avx2")))
+    Bitboard legalMovesAvx2(Bitboard mine, Bitboard theirs) {
+        const __m256i shift1 = _mm256_set_epi64x(7, 9, 8, 1);
+        const __m256i shift2 = _mm256_add_epi64(shift1, shift1);
+        const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+        const __m256i m = _mm256_set1_epi64x((long long)mine);
+        const __m256i t = _mm256_and_si256(_mm256_set1_epi64x((long long)theirs),
+                                           _mm256_set_epi64x((long long)THROUGH_DIAGONAL, (long long)THROUGH_DIAGONAL, -1, (long long)THROUGH_HORIZONTAL));
+
+        __m256i up = _mm256_and_si256(_mm256_sllv_epi64(m, shift1), t);
+        __m256i down = _mm256_and_si256(_mm256_srlv_epi64(m, shift1), t);
+        __m256i throughUp = t, throughDown = t;
+        up = _mm256_or_si256(up, _mm256_and_si256(throughUp, _mm256_sllv_epi64(up, shift1)));
+        down = _mm256_or_si256(down, _mm256_and_si256(throughDown, _mm256_srlv_epi64(down, shift1)));
+        throughUp = _mm256_and_si256(throughUp, _mm256_sllv_epi64(throughUp, shift1));
+        throughDown = _mm256_and_si256(throughDown, _mm256_srlv_epi64(throughDown, shift1));
+        up = _mm256_or_si256(up, _mm256_and_si256(throughUp, _mm256_sllv_epi64(up, shift2)));
+        down = _mm256_or_si256(down, _mm256_and_si256(throughDown, _mm256_srlv_epi64(down, shift2)));
+        throughUp = _mm256_and_si256(throughUp, _mm256_sllv_epi64(throughUp, shift2));
+        throughDown = _mm256_and_si256(throughDown, _mm256_srlv_epi64(throughDown, shift2));
+        up = _mm256_or_si256(up, _mm256_and_si256(throughUp, _mm256_sllv_epi64(up, shift4)));
+        down = _mm256_or_si256(down, _mm256_and_si256(throughDown, _mm256_srlv_epi64(down, shift4)));
+
+        __m256i moves = _mm256_or_si256(_mm256_sllv_epi64(up, shift1), _mm256_srlv_epi64(down, shift1));
+        __m128i half = _mm_or_si128(_mm256_castsi256_si128(moves), _mm256_extracti128_si256(moves, 1));
+        half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+        return (Bitboard)_mm_cvtsi128_si64(half) & ~(mine | theirs);
+    }
+#endif
+
+    typedef Bitboard (*MoveGenerator)(Bitboard mine, Bitboard theirs);
+
+    MoveGenerator generatorFor(MoveGenPath path) {
+#ifdef POSITION_SIMD
+        if (path == MoveGenPath::AVX2)
+            return legalMovesAvx2;
+        if (path == MoveGenPath::SSE2)
+            return legalMovesSse2;
+#endif
+        return legalMovesScalar;
+    }
+
+    /// Picks the generator on the first call, then hands over to it.
+    Bitboard firstLegalMoves(Bitboard mine, Bitboard theirs);
+
+    /// The generator legalMoves() calls. It starts out as a constant, so moves can be generated even during static initialization.
+    std::atomic<MoveGenerator> moveGenerator(firstLegalMoves);
+
+    Bitboard firstLegalMoves(Bitboard mine, Bitboard theirs) {
+        MoveGenerator best = generatorFor(bestMoveGenPath());
+        moveGenerator.store(best, std::memory_order_relaxed);
+        return best(mine, theirs);
+    }
+}
+
+
+MoveGenPath othello::bestMoveGenPath() {
+#ifdef POSITION_SIMD
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? MoveGenPath::AVX2 : MoveGenPath::SSE2;
+#else
+    return MoveGenPath::SCALAR;
+#endif
+}
+
+
+const char* othello::moveGenPathName(MoveGenPath path) {
+    switch (path) {
+        case MoveGenPath::SSE2:
+            return "SSE2";
+        case MoveGenPath::AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
+
+
+Bitboard othello::legalMovesOn(MoveGenPath path, Bitboard mine, Bitboard theirs) {
+    if (path > bestMoveGenPath())
+        path = bestMoveGenPath();
+    return generatorFor(path)(mine, theirs);
+}
+
+
+Position Position::empty() {
+    return Position{{0, 0}, SIDE_BLACK};
+}
+
+
+Position Position::initial() {
+    // same four starting discs that applicationInit places
+    Position pos = empty();
+    pos.addDisc(SIDE_BLACK, squareOf(TilePoint{4, 4}));
+    pos.addDisc(SIDE_BLACK, squareOf(TilePoint{5, 5}));
+    pos.addDisc(SIDE_WHITE, squareOf(TilePoint{5, 4}));
+    pos.addDisc(SIDE_WHITE, squareOf(TilePoint{4, 5}));
+    return pos;
+}
+
+
+std::string othello::squareName(int sq) {
+    return std::string{(char)('a' + (sq & 7)), (char)('1' + (sq >> 3))};
+}
+
+
+bool othello::parseSquare(const std::string& name, int& sq) {
+    if (name.size() != 2)
+        return false;
+    int x = std::tolower((unsigned char)name[0]) - 'a';
+    int y = name[1] - '1';
+    if ((x < 0) || (x > 7) || (y < 0) || (y > 7))
+        return false;
+    sq = y * 8 + x;
+    return true;
+}
+
+
+std::string Position::toText() const {
+    std::string text;
+    for (int sq = 0; sq < NUM_SQUARES; sq++) {
+        Side owner;
+        text += ownerOf(sq, owner) ? ((owner == SIDE_BLACK) ? 'X' : 'O') : '-';
+    }
+    text += (toMove == SIDE_BLACK) ? " X" : " O";
+    return text;
+}
+
+
+bool Position::fromText(const std::string& text, Position& pos) {
+    Position read = empty();
+    int sq = 0;
+    size_t i = 0;
+    for (; (i < text.size()) && (sq < NUM_SQUARES); i++) {
+        char c = (char)std::toupper((unsigned char)text[i]);
+        if (std::isspace((unsigned char)c))
+            continue;
+        if (c == 'X')
+            read.addDisc(SIDE_BLACK, sq);
+        else if (c == 'O')
+            read.addDisc(SIDE_WHITE, sq);
+        else if ((c != '-') && (c != '.'))
+            return false;
+        sq++;
+    }
+    if (sq < NUM_SQUARES)
+        return false;
+    
+    // then the side to move, if given, and nothing else
+    bool haveSide = false;
+    for (; i < text.size(); i++) {
+        char c = (char)std::toupper((unsigned char)text[i]);
+        if (std::isspace((unsigned char)c))
+            continue;
+        if (haveSide || ((c != 'X') && (c != 'O')))
+            return false;
+        read.toMove = (c == 'X') ? SIDE_BLACK : SIDE_WHITE;
+        haveSide = true;
+    }
+    pos = read;
+    return true;
+}
+
+
+Bitboard Position::legalMoves(Side who) const {
+    return moveGenerator.load(std::memory_order_relaxed)(discs[who], discs[opponentOf(who)]);
+}
+
+
+Bitboard Position::flipsInDirection(Side who, int sq, int dir) const {
+    return flips(who, sq) & RAYS[sq][dir];
+}
+
+
+Bitboard Position::flips(Side who, int sq) const {
+    // per line: the outflanking discs of mine, then the discs between them & sq, put back onto the board
+    const Bitboard mine = discs[who];
+    const Bitboard theirs = discs[opponentOf(who)];
+    const int x = sq & 7, y = sq >> 3;
+    const FlipTables& t = FLIP_TABLES;
+
+    unsigned int out = t.outflank[x][(theirs >> (8 * y + 1)) & 0x3F] & (unsigned int)(mine >> (8 * y));
+    Bitboard flipped = (Bitboard)t.flipped[x][out] << (8 * y);
+
+    out = t.outflank[y][(columnByte(theirs, x) >> 1) & 0x3F] & columnByte(mine, x);
+    flipped |= COLUMN_SPREAD[t.flipped[y][out]] << x;
+
+    out = t.outflank[x][(diagonalByte(theirs, t.diagonal9[sq]) >> 1) & 0x3F] & diagonalByte(mine, t.diagonal9[sq]);
+    flipped |= (t.flipped[x][out] * COLUMN_1) & t.diagonal9[sq];
+
+    out = t.outflank[x][(diagonalByte(theirs, t.diagonal7[sq]) >> 1) & 0x3F] & diagonalByte(mine, t.diagonal7[sq]);
+    flipped |= (t.flipped[x][out] * COLUMN_1) & t.diagonal7[sq];
+    return flipped;
+}
+
+
+Bitboard Position::flippableDiscs(Side victim) const {
+    Side attacker = opponentOf(victim);
+    Bitboard moves = legalMoves(attacker);
+    Bitboard flippable = 0;
+    while (moves) {
+        flippable |= flips(attacker, popLowestSquare(moves));
+    }
+    return flippable;
+}
+
+
+Bitboard Position::play(int sq) {
+    Bitboard flipped = flips(toMove, sq);
+    discs[toMove] |= flipped | squareBit(sq);
+    discs[opponentOf(toMove)] &= ~flipped;
+    toMove = opponentOf(toMove);
+    return flipped;
+}
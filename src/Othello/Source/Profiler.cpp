@@ -0,0 +1,186 @@
+//
+//  Profiler.cpp
+//  Othello
+//
+
+#include "Profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace othello;
+
+
+namespace {
+    /// Zones each thread keeps; once a thread has recorded more, its oldest ones are overwritten.
+    const uint64_t RING_CAPACITY = 1 << 16;
+
+    /// One finished zone. The fields are atomic only so a dump can read them while the owning thread overwrites them.
+    struct Event {
+        std::atomic<const char*> name;
+        std::atomic<int64_t> startNs;
+        std::atomic<int64_t> durationNs;
+    };
+
+    /// A thread's ring of zones. Only that thread writes to it, so recording needs no lock.
+    struct ThreadBuffer {
+        /// Trace thread id (order the thread first recorded in) and display name (guarded by registryMutex()).
+        unsigned int tid;
+        std::string name;
+
+        Event events[RING_CAPACITY];
+
+        /// Zones recorded so far: zone i is (or was, until overwritten) in events[i % RING_CAPACITY].
+        std::atomic<uint64_t> count;
+    };
+
+    /// Every thread's buffer, kept after the thread exits so its zones can still be dumped.
+    std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::vector<std::unique_ptr<ThreadBuffer>>& registry() {
+        static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        return buffers;
+    }
+
+    thread_local ThreadBuffer* localBuffer = nullptr;
+
+    /// The calling thread's buffer, registered on first use.
+    ThreadBuffer& threadBuffer() {
+        if (!localBuffer) {
+            auto buffer = std::make_unique<ThreadBuffer>();
+            buffer->count = 0;
+            std::lock_guard<std::mutex> lock(registryMutex());
+            buffer->tid = (unsigned int)registry().size();
+            buffer->name = "thread " + std::to_string(buffer->tid);
+            localBuffer = buffer.get();
+            registry().push_back(std::move(buffer));
+        }
+        return *localBuffer;
+    }
+
+    /// Nanoseconds since the first zone (or dump) of the program.
+    int64_t nowNs() {
+        static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    /// Writes 's' as a JSON string.
+    void writeJsonString(std::ostream& out, const std::string& s) {
+        out << '"';
+        for (char c : s) {
+            if ((c == '"') || (c == '\\'))
+                out << '\\';
+            out << c;
+        }
+        out << '"';
+    }
+
+    /// Writes a time in nanoseconds as microseconds (the trace's unit), to the nanosecond.
+    void writeMicroseconds(std::ostream& out, int64_t ns) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%lld.%03lld", (long long)(ns / 1000), (long long)(ns % 1000));
+        out << text;
+    }
+
+    /// A zone copied out of a ring.
+    struct CopiedEvent {
+        const char* name;
+        int64_t startNs;
+        int64_t durationNs;
+    };
+}
+
+
+bool profiler::enabled() {
+#ifdef OTHELLO_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void profiler::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex());
+    buffer.name = name;
+}
+
+
+profiler::Zone::Zone(const char* name)
+    :   name_(name)
+{
+    // a thread's first zone allocates its buffer before the clock starts, so that isn't timed as part of the zone
+    threadBuffer();
+    startNs_ = nowNs();
+}
+
+
+profiler::Zone::~Zone() {
+    int64_t endNs = nowNs();
+    ThreadBuffer& buffer = threadBuffer();
+    uint64_t i = buffer.count.load(std::memory_order_relaxed);
+    // a dump that reads any of the new fields then also sees the count from before this zone, so it knows the old zone is gone
+    std::atomic_thread_fence(std::memory_order_release);
+    Event& event = buffer.events[i % RING_CAPACITY];
+    event.name.store(name_, std::memory_order_relaxed);
+    event.startNs.store(startNs_, std::memory_order_relaxed);
+    event.durationNs.store(endNs - startNs_, std::memory_order_relaxed);
+    // publishes the event to a dump that reads the count with acquire
+    buffer.count.store(i + 1, std::memory_order_release);
+}
+
+
+void profiler::writeChromeTrace(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    std::vector<CopiedEvent> copied;
+    for (const auto& buffer : registry()) {
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+        writeJsonString(out, buffer->name);
+        out << "}}";
+        first = false;
+
+        // copy the newest zones, then drop any the thread overwrote while they were being copied
+        uint64_t end = buffer->count.load(std::memory_order_acquire);
+        uint64_t begin = (end > RING_CAPACITY) ? end - RING_CAPACITY : 0;
+        copied.clear();
+        for (uint64_t i = begin; i < end; i++) {
+            const Event& event = buffer->events[i % RING_CAPACITY];
+            copied.push_back(CopiedEvent{event.name.load(std::memory_order_relaxed), event.startNs.load(std::memory_order_relaxed), event.durationNs.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t endAfter = buffer->count.load(std::memory_order_relaxed);
+        // zone i is overwritten by zone i + RING_CAPACITY, which may already be half written once the count reaches it
+        uint64_t skip = (endAfter >= begin + RING_CAPACITY) ? std::min<uint64_t>(endAfter - begin - RING_CAPACITY + 1, copied.size()) : 0;
+
+        for (size_t i = skip; i < copied.size(); i++) {
+            out << ",\n{\"name\":";
+            writeJsonString(out, copied[i].name);
+            out << ",\"cat\":\"othello\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":";
+            writeMicroseconds(out, copied[i].startNs);
+            out << ",\"dur\":";
+            writeMicroseconds(out, copied[i].durationNs);
+            out << "}";
+        }
+    }
+    out << "\n]}" << std::endl;
+}
+
+
+bool profiler::writeChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    writeChromeTrace(out);
+    return (bool)out;
+}
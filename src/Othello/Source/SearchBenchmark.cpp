@@ -0,0 +1,154 @@
+//
+//  SearchBenchmark.cpp
+//  Othello
+//
+
+#include "SearchBenchmark.hpp"
+#include <chrono>
+#include <iomanip>
+#include <utility>
+
+using namespace othello;
+
+
+// plies from the start at which positions are taken
+static const unsigned int BENCHMARK_PLIES[] = {8, 12, 16, 20, 24, 28, 32, 36, 40, 44};
+
+
+std::vector<Position> othello::benchmarkPositions() {
+    std::vector<Position> positions;
+    Position pos = Position::initial();
+    unsigned int next = 0;
+    uint32_t choice = 12345;
+    for (unsigned int ply = 0; next < sizeof(BENCHMARK_PLIES) / sizeof(BENCHMARK_PLIES[0]); ply++) {
+        Bitboard moves = pos.legalMoves();
+        if (moves == 0) {
+            pos.pass();
+            moves = pos.legalMoves();
+            if (moves == 0)
+                break; // game over before the last ply, the set is just shorter
+        }
+        if (ply == BENCHMARK_PLIES[next]) {
+            positions.push_back(pos);
+            next++;
+        }
+
+        // fixed pseudo-random choice among the legal moves, so the set is the same on every run
+        choice = choice * 1103515245 + 12345;
+        unsigned int skip = (choice >> 16) % popCount(moves);
+        for (unsigned int i = 0; i < skip; i++) {
+            popLowestSquare(moves);
+        }
+        pos.play(lowestSquare(moves));
+    }
+    return positions;
+}
+
+
+std::vector<Position> othello::evalBenchmarkPositions(size_t count) {
+    std::vector<Position> positions;
+    positions.reserve(count);
+    uint32_t choice = 12345;
+    while (positions.size() < count) {
+        Position pos = Position::initial();
+        while (positions.size() < count) {
+            Bitboard moves = pos.legalMoves();
+            if (moves == 0) {
+                pos.pass();
+                moves = pos.legalMoves();
+                if (moves == 0)
+                    break;
+            }
+            positions.push_back(pos);
+
+            choice = choice * 1103515245 + 12345;
+            unsigned int skip = (choice >> 16) % popCount(moves);
+            for (unsigned int i = 0; i < skip; i++) {
+                popLowestSquare(moves);
+            }
+            pos.play(lowestSquare(moves));
+        }
+    }
+    return positions;
+}
+
+
+std::vector<EvalBenchmarkResult> othello::runEvalBenchmark(const PatternEvaluator& eval, size_t numPositions, std::ostream* log) {
+    std::vector<Position> positions = evalBenchmarkPositions(numPositions);
+    std::vector<int> expected(positions.size());
+    std::vector<int> scores(positions.size());
+    std::vector<EvalBenchmarkResult> results;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < positions.size(); i++) {
+        expected[i] = eval.evaluate(positions[i], positions[i].toMove);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    results.push_back(EvalBenchmarkResult{"single", positions.size() / seconds, 1.0, 0});
+
+    for (int path = (int)BatchPath::SCALAR; path <= (int)PatternEvaluator::bestBatchPath(); path++) {
+        start = std::chrono::steady_clock::now();
+        eval.evaluateBatch(positions.data(), positions.size(), scores.data(), (BatchPath)path);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        EvalBenchmarkResult result = EvalBenchmarkResult{std::string("batch ") + batchPathName((BatchPath)path), positions.size() / seconds, 0, 0};
+        result.speedup = result.positionsPerSecond / results.front().positionsPerSecond;
+        for (size_t i = 0; i < positions.size(); i++) {
+            result.mismatches += (scores[i] != expected[i]);
+        }
+        results.push_back(result);
+    }
+
+    if (log) {
+        for (const EvalBenchmarkResult& result : results) {
+            *log << std::setw(14) << result.method << ": " << std::fixed << std::setprecision(0) << result.positionsPerSecond << " positions/s, "
+                 << std::setprecision(2) << result.speedup << "x";
+            if (result.mismatches)
+                *log << ", " << result.mismatches << " scores differ from single!";
+            *log << std::endl;
+        }
+    }
+    return results;
+}
+
+
+std::vector<ThreadBenchmarkResult> othello::runThreadBenchmark(AiMind& ai, unsigned int depth, const std::vector<unsigned int>& threadCounts, std::ostream* log) {
+    std::vector<Position> positions = benchmarkPositions();
+    std::vector<ThreadBenchmarkResult> results;
+    std::vector<std::pair<int, int>> expected; // (move, score) per position, with the first thread count
+    for (unsigned int threads : threadCounts) {
+        ai.setSearchThreads(threads);
+        ai.clearSearchState();
+
+        ThreadBenchmarkResult result = ThreadBenchmarkResult{threads, 0, 0, 1.0, 0};
+        std::vector<std::pair<int, int>> chosen;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (const Position& pos : positions) {
+            std::vector<int> rootMoves;
+            Bitboard moves = pos.legalMoves();
+            while (moves) {
+                rootMoves.push_back(popLowestSquare(moves));
+            }
+            unsigned int best = ai.bestMove(pos, rootMoves, SearchLimits{depth, 0, 0});
+            result.nodes += ai.getLastSearchInfo().nodes;
+            chosen.emplace_back(rootMoves[best], ai.getLastSearchInfo().score);
+        }
+        if (expected.empty())
+            expected = chosen;
+        for (size_t i = 0; i < chosen.size(); i++) {
+            result.mismatches += (chosen[i] != expected[i]);
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!results.empty() && (result.seconds > 0))
+            result.speedup = results.front().seconds / result.seconds;
+        results.push_back(result);
+
+        if (log) {
+            *log << std::setw(3) << threads << " threads: " << std::fixed << std::setprecision(3) << result.seconds << "s, "
+                 << result.nodes << " nodes, speedup " << std::setprecision(2) << result.speedup << "x";
+            if (result.mismatches)
+                *log << ", " << result.mismatches << " moves/scores differ from " << threadCounts.front() << " thread(s)";
+            *log << std::endl;
+        }
+    }
+    return results;
+}
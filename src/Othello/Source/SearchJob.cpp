@@ -0,0 +1,65 @@
+//
+//  SearchJob.cpp
+//  Othello
+//
+
+#include "SearchJob.hpp"
+#include "Profiler.hpp"
+
+using namespace othello;
+
+
+SearchJob::SearchJob(std::shared_ptr<AiMind> mind)
+    :   mind_(mind),
+        stopFlag_(false),
+        finished_(false),
+        result_(0),
+        running_(false)
+{
+}
+
+
+SearchJob::~SearchJob() {
+    cancel();
+}
+
+
+void SearchJob::start(const Position& pos, const std::vector<int>& rootMoves, const SearchLimits& limits) {
+    cancel(); // in case the last result was never collected
+    stopFlag_ = false;
+    finished_ = false;
+    running_ = true;
+    startTime_ = std::chrono::steady_clock::now();
+
+    SearchLimits jobLimits = limits;
+    jobLimits.stopFlag = &stopFlag_;
+    worker_ = std::thread([this, pos, rootMoves, jobLimits] {
+        PROFILE_THREAD("search job");
+        result_ = mind_->bestMove(pos, rootMoves, jobLimits);
+        finished_.store(true, std::memory_order_release);
+    });
+}
+
+
+bool SearchJob::poll(unsigned int& moveIndex) {
+    if (!running_ || !finished_.load(std::memory_order_acquire))
+        return false;
+    worker_.join();
+    running_ = false;
+    moveIndex = result_;
+    return true;
+}
+
+
+void SearchJob::stop() {
+    stopFlag_ = true;
+}
+
+
+void SearchJob::cancel() {
+    if (worker_.joinable()) {
+        stopFlag_ = true;
+        worker_.join();
+    }
+    running_ = false;
+}
@@ -0,0 +1,134 @@
+//
+//  Stability.cpp
+//  Othello
+//
+
+#include "Stability.hpp"
+
+using namespace othello;
+
+
+namespace {
+    /// Number of configurations of an 8-square line (empty / mine / theirs per square).
+    const int NUM_LINE_CONFIGS = 6561;
+
+    /// Edge lookup tables, built once at startup.
+    struct EdgeTables {
+        /// Base-3 value of a byte: sum of 3^i over its set bits i. A line's configuration is ternary[mine] + 2 * ternary[theirs].
+        uint16_t ternary[256];
+
+        /// For every line configuration, the squares (of either color) that no play along the line can flip.
+        uint8_t stable[NUM_LINE_CONFIGS];
+
+        EdgeTables() {
+            for (int b = 0; b < 256; b++) {
+                ternary[b] = 0;
+                for (int i = 0, power = 1; i < 8; i++, power *= 3) {
+                    if (b & (1 << i))
+                        ternary[b] += (uint16_t)power;
+                }
+            }
+            bool done[NUM_LINE_CONFIGS] = {};
+            for (int mine = 0; mine < 256; mine++) {
+                for (int theirs = 0; theirs < 256; theirs++) {
+                    if ((mine & theirs) == 0)
+                        solve(mine, theirs, done);
+                }
+            }
+        }
+
+        /// Works out stable[] for a line by trying every play on it, by either side, recursively. Any empty square can be
+        /// filled by either side at some point (a move can flip along another line), so every placement counts, flipping or not.
+        uint8_t solve(int mine, int theirs, bool* done) {
+            int config = ternary[mine] + 2 * ternary[theirs];
+            if (done[config])
+                return stable[config];
+            int occupied = mine | theirs;
+            uint8_t result = (uint8_t)occupied;
+            for (int sq = 0; sq < 8; sq++) {
+                if (occupied & (1 << sq))
+                    continue;
+                for (int side = 0; side < 2; side++) {
+                    int own = side ? theirs : mine;
+                    int other = side ? mine : theirs;
+                    int flipped = lineFlips(own, other, sq);
+                    own |= (1 << sq) | flipped;
+                    other &= ~flipped;
+                    uint8_t childStable = side ? solve(other, own, done) : solve(own, other, done);
+                    result &= childStable & ~flipped;
+                }
+            }
+            done[config] = true;
+            stable[config] = result;
+            return result;
+        }
+
+        /// Discs of 'other' flipped along the line by 'own' placing on 'sq'.
+        static int lineFlips(int own, int other, int sq) {
+            int flipped = 0;
+            for (int dir : {-1, 1}) {
+                int run = 0;
+                int i = sq + dir;
+                while ((i >= 0) && (i < 8) && (other & (1 << i))) {
+                    run |= 1 << i;
+                    i += dir;
+                }
+                if ((i >= 0) && (i < 8) && (own & (1 << i)))
+                    flipped |= run;
+            }
+            return flipped;
+        }
+    };
+
+    const EdgeTables EDGE_TABLES;
+
+    /// Stable squares (either color) of the line whose discs are 'mine' & 'theirs' (as bytes).
+    inline unsigned int edgeStable(unsigned int mine, unsigned int theirs) {
+        return EDGE_TABLES.stable[EDGE_TABLES.ternary[mine] + 2 * EDGE_TABLES.ternary[theirs]];
+    }
+
+    /// Spreads 'b' along a line direction both ways, as far as the board goes: every square sharing such a line with a square of 'b'.
+    /// 'shift' is the direction's step, and the masks clear the columns a shift by 1, 2 or 4 steps towards higher bits wraps into.
+    inline Bitboard spreadLine(Bitboard b, int shift, Bitboard up1, Bitboard down1, Bitboard up2, Bitboard down2, Bitboard up4, Bitboard down4) {
+        b |= ((b << shift) & up1) | ((b >> shift) & down1);
+        b |= ((b << (2 * shift)) & up2) | ((b >> (2 * shift)) & down2);
+        b |= ((b << (4 * shift)) & up4) | ((b >> (4 * shift)) & down4);
+        return b;
+    }
+}
+
+
+Bitboard othello::stableDiscs(Bitboard mine, Bitboard theirs) {
+    // edges: straight from the table
+    Bitboard edges = (Bitboard)edgeStable((unsigned int)(mine & 0xFF), (unsigned int)(theirs & 0xFF));
+    edges |= (Bitboard)edgeStable((unsigned int)(mine >> 56), (unsigned int)(theirs >> 56)) << 56;
+    edges |= COLUMN_SPREAD[edgeStable(columnByte(mine, 0), columnByte(theirs, 0))];
+    edges |= COLUMN_SPREAD[edgeStable(columnByte(mine, 7), columnByte(theirs, 7))] << 7;
+    Bitboard stable = mine & edges;
+
+    // lines with no empty square left in each direction
+    const Bitboard occupied = mine | theirs;
+    Bitboard rows = occupied & (occupied >> 1);
+    rows &= rows >> 2;
+    rows &= rows >> 4;
+    Bitboard fullRows = (rows & COLUMN_1) * 0xFF;
+    Bitboard cols = occupied & ((occupied >> 32) | (occupied << 32));
+    cols &= (cols >> 16) | (cols << 48);
+    Bitboard fullCols = cols & ((cols >> 8) | (cols << 56));
+    Bitboard empty = ~occupied;
+    Bitboard fullDiag9 = ~spreadLine(empty, 9, NOT_COLUMN_1, NOT_COLUMN_8, 0xFCFCFCFCFCFCFCFCULL, 0x3F3F3F3F3F3F3F3FULL, 0xF0F0F0F0F0F0F0F0ULL, 0x0F0F0F0F0F0F0F0FULL);
+    Bitboard fullDiag7 = ~spreadLine(empty, 7, NOT_COLUMN_8, NOT_COLUMN_1, 0x3F3F3F3F3F3F3F3FULL, 0xFCFCFCFCFCFCFCFCULL, 0x0F0F0F0F0F0F0F0FULL, 0xF0F0F0F0F0F0F0F0ULL);
+
+    // inner discs: in every direction, a full line or a stable disc of mine next to it; repeat until nothing new is stable
+    Bitboard candidates = mine & INNER_SQUARES;
+    while (true) {
+        Bitboard horizontal = fullRows | shiftDir(stable, 2) | shiftDir(stable, 3);
+        Bitboard vertical = fullCols | shiftDir(stable, 0) | shiftDir(stable, 1);
+        Bitboard diag9 = fullDiag9 | shiftDir(stable, 4) | shiftDir(stable, 5);
+        Bitboard diag7 = fullDiag7 | shiftDir(stable, 6) | shiftDir(stable, 7);
+        Bitboard found = candidates & horizontal & vertical & diag9 & diag7 & ~stable;
+        if (found == 0)
+            return stable;
+        stable |= found;
+    }
+}
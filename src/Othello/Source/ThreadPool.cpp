@@ -0,0 +1,74 @@
+//
+//  ThreadPool.cpp
+//  Othello
+//
+
+#include "ThreadPool.hpp"
+#include "Profiler.hpp"
+
+using namespace othello;
+
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+    :   busy_(0),
+        stopping_(false)
+{
+    if (numThreads == 0)
+        numThreads = 1;
+    for (unsigned int i = 0; i < numThreads; i++) {
+        workers_.emplace_back(&ThreadPool::workerLoop_, this, i);
+    }
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    taskReady_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+
+void ThreadPool::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    taskReady_.notify_one();
+}
+
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    allDone_.wait(lock, [this] { return tasks_.empty() && (busy_ == 0); });
+}
+
+
+void ThreadPool::workerLoop_(unsigned int workerId) {
+    PROFILE_THREAD("pool worker " + std::to_string(workerId));
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            taskReady_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+                return; // stopping, and nothing left to do
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            busy_++;
+        }
+
+        task(workerId);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_--;
+            if (tasks_.empty() && (busy_ == 0))
+                allDone_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,163 @@
+//
+//  TranspositionTable.cpp
+//  Othello
+//
+
+#include "TranspositionTable.hpp"
+#include <algorithm>
+
+using namespace othello;
+
+
+// two entries per bucket lets a deep result survive while the bucket keeps taking fresh shallow ones
+const unsigned int TranspositionTable::BUCKET_SIZE_ = 2;
+
+
+TranspositionTable::TranspositionTable(size_t sizeMB, ReplacementPolicy policy)
+    :   numSlots_(0),
+        bucketMask_(0),
+        policy_(policy),
+        age_(0),
+        stats_(TTStats{})
+{
+    resize(sizeMB);
+}
+
+
+void TranspositionTable::resize(size_t sizeMB) {
+    size_t bucketBytes = BUCKET_SIZE_ * sizeof(Slot);
+    size_t maxBuckets = (sizeMB * 1024 * 1024) / bucketBytes;
+
+    // largest power of 2 that fits the budget (at least 1 bucket)
+    size_t numBuckets = 1;
+    while (numBuckets * 2 <= maxBuckets) {
+        numBuckets *= 2;
+    }
+
+    numSlots_ = numBuckets * BUCKET_SIZE_;
+    slots_.reset(new Slot[numSlots_]);
+    bucketMask_ = numBuckets - 1;
+    clear();
+}
+
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < numSlots_; i++) {
+        slots_[i].check.store(0, std::memory_order_relaxed);
+        slots_[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+void TranspositionTable::newSearch() {
+    age_++;
+}
+
+
+uint64_t TranspositionTable::pack_(const TTEntry& entry) {
+    return (uint64_t)(uint32_t)entry.score
+        | ((uint64_t)(uint8_t)entry.bestMove << 32)
+        | ((uint64_t)entry.depth << 40)
+        | ((uint64_t)entry.bound << 48)
+        | ((uint64_t)entry.age << 56);
+}
+
+
+TTEntry TranspositionTable::unpack_(uint64_t key, uint64_t data) {
+    return TTEntry{key, (int32_t)(uint32_t)data, (int8_t)(uint8_t)(data >> 32), (uint8_t)(data >> 40), (BoundType)(uint8_t)(data >> 48), (uint8_t)(data >> 56)};
+}
+
+
+TTEntry TranspositionTable::read_(const Slot& slot) {
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t key = slot.check.load(std::memory_order_relaxed) ^ data;
+    return unpack_(key, data);
+}
+
+
+void TranspositionTable::write_(Slot& slot, const TTEntry& entry) {
+    uint64_t data = pack_(entry);
+    slot.check.store(entry.key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& out, TTStats& stats) const {
+    stats.probes++;
+    const Slot* bucket = &slots_[(key & bucketMask_) * BUCKET_SIZE_];
+    for (unsigned int i = 0; i < BUCKET_SIZE_; i++) {
+        // a slot half-written by another thread decodes to some other key, and is skipped
+        TTEntry entry = read_(bucket[i]);
+        if ((entry.bound != BoundType::NONE) && (entry.key == key)) {
+            stats.hits++;
+            out = entry;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void TranspositionTable::store(uint64_t key, unsigned int depth, BoundType bound, int score, int bestMove, TTStats& stats) {
+    stats.stores++;
+    Slot* bucket = &slots_[(key & bucketMask_) * BUCKET_SIZE_];
+    TTEntry newEntry = TTEntry{key, score, (int8_t)bestMove, (uint8_t)depth, bound, age_};
+
+    TTEntry current[BUCKET_SIZE_];
+    for (unsigned int i = 0; i < BUCKET_SIZE_; i++) {
+        current[i] = read_(bucket[i]);
+    }
+
+    // a position that's already stored is always refreshed in place
+    for (unsigned int i = 0; i < BUCKET_SIZE_; i++) {
+        if ((current[i].bound != BoundType::NONE) && (current[i].key == key)) {
+            write_(bucket[i], newEntry);
+            return;
+        }
+    }
+
+    // otherwise evict the least valuable slot: empty first, then left over from an older search, then shallowest
+    auto worth = [this](const TTEntry& e) {
+        if (e.bound == BoundType::NONE)
+            return -1;
+        return (e.age == age_ ? 256 : 0) + e.depth;
+    };
+    unsigned int weakest = 0;
+    for (unsigned int i = 1; i < BUCKET_SIZE_; i++) {
+        if (worth(current[i]) < worth(current[weakest]))
+            weakest = i;
+    }
+
+    unsigned int victim = weakest;
+    switch (policy_) {
+        case ReplacementPolicy::ALWAYS_REPLACE:
+            break;
+
+        case ReplacementPolicy::DEPTH_PREFERRED:
+            if ((current[victim].bound != BoundType::NONE) && (current[victim].age == age_) && (depth < current[victim].depth)) {
+                stats.rejected++;
+                return;
+            }
+            break;
+
+        case ReplacementPolicy::TWO_TIER: {
+            const TTEntry& deepSlot = current[0];
+            const TTEntry& anySlot = current[1];
+            if ((deepSlot.bound == BoundType::NONE) || (deepSlot.age != age_) || (depth >= deepSlot.depth)) {
+                // new entry takes the depth-preferred slot; what it displaces moves down to the always-replace slot
+                if (anySlot.bound != BoundType::NONE && deepSlot.bound != BoundType::NONE)
+                    stats.overwrites++;
+                if (deepSlot.bound != BoundType::NONE)
+                    write_(bucket[1], deepSlot);
+                write_(bucket[0], newEntry);
+                return;
+            }
+            victim = 1;
+            break;
+        }
+    }
+
+    if (current[victim].bound != BoundType::NONE)
+        stats.overwrites++;
+    write_(bucket[victim], newEntry);
+}
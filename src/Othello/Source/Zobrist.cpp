@@ -0,0 +1,80 @@
+//
+//  Zobrist.cpp
+//  Othello
+//
+
+#include "Zobrist.hpp"
+
+using namespace othello;
+
+
+namespace {
+    /// All keys, generated once from a fixed seed so hashes are the same on every run (and every machine).
+    struct ZobristKeys {
+        uint64_t squares[2][NUM_SQUARES];
+
+        /// squares[BLACK][sq] ^ squares[WHITE][sq], i.e. the change when the disc on 'sq' is flipped.
+        uint64_t flip[NUM_SQUARES];
+
+        uint64_t whiteToMove;
+
+        ZobristKeys() {
+            uint64_t state = 0x9E3779B97F4A7C15ULL;
+            for (int s = 0; s < 2; s++) {
+                for (int sq = 0; sq < NUM_SQUARES; sq++) {
+                    squares[s][sq] = next(state);
+                }
+            }
+            for (int sq = 0; sq < NUM_SQUARES; sq++) {
+                flip[sq] = squares[SIDE_BLACK][sq] ^ squares[SIDE_WHITE][sq];
+            }
+            whiteToMove = next(state);
+        }
+
+        /// splitmix64 step
+        static uint64_t next(uint64_t& state) {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+    };
+
+    const ZobristKeys KEYS;
+}
+
+
+uint64_t zobrist::squareKey(Side side, int sq) {
+    return KEYS.squares[side][sq];
+}
+
+
+uint64_t zobrist::whiteToMoveKey() {
+    return KEYS.whiteToMove;
+}
+
+
+uint64_t zobrist::hashOf(const Position& pos) {
+    uint64_t hash = 0;
+    for (int s = 0; s < 2; s++) {
+        Bitboard discs = pos.discs[s];
+        while (discs) {
+            hash ^= KEYS.squares[s][popLowestSquare(discs)];
+        }
+    }
+    if (pos.toMove == SIDE_WHITE) {
+        hash ^= KEYS.whiteToMove;
+    }
+    return hash;
+}
+
+
+uint64_t zobrist::moveDelta(const MoveUndo& move) {
+    // new disc, every flipped disc, and the turn passing to the other side
+    uint64_t delta = KEYS.squares[move.mover][move.square] ^ KEYS.whiteToMove;
+    Bitboard flipped = move.flipped;
+    while (flipped) {
+        delta ^= KEYS.flip[popLowestSquare(flipped)];
+    }
+    return delta;
+}
@@ -22,6 +22,10 @@
 #include "GameState.hpp"
 #include "Player.hpp"
 #include "AiMind.hpp"
+#include "AiConfig.hpp"
+#include "SearchJob.hpp"
+#include "OpeningBook.hpp"
+#include "Profiler.hpp"
 
 using namespace std;
 using namespace othello;
@@ -30,7 +34,10 @@ bool showingWhiteMoves = false;
 bool showingBlackMoves = false;
 bool turnStarted = false;
 
-const unsigned int MINIMAX_DEPTH = 4;
+// the AI's settings (search limits, weights, files) are in AiConfig.hpp
+
+/// Where 'p' writes the profiler's Chrome trace (only recorded in builds with OTHELLO_PROFILE defined).
+const char* TRACE_PATH = "othello-trace.json";
 
 /// Was the last turn ended because the player had no valid moves?
 /// In othello, the game can end early (before the board is filled) if neither player has a valid move.
@@ -39,15 +46,6 @@ bool lastMoveInvalid = false;
 float cur_ai_turn_wait = 0;
 const float SECS_BETWEEN_AI_MOVES = 1.0;
 
-// weights for each factor based on their importance
-// used in computing Gamestate Advantage Score (measures how "good" a player's current gamestate is)
-const unsigned int NUM_DISC_WEIGHT = 3;
-const unsigned int MOBILITY_WEIGHT = 1;
-const unsigned int STABILITY_WEIGHT = 2;
-const unsigned int CORNER_WEIGHT = 4;
-const int NUM_FRONTIER_WEIGHT = -1;
-const int CORNER_ADJ_WEIGHT = -2;
-
 
 vector<shared_ptr<GraphicObject>> allObjects; // objects to be rendered
 
@@ -58,6 +56,24 @@ shared_ptr<Player> playerWhite;
 shared_ptr<Player> playerBlack;
 shared_ptr<AiMind> AI_MIND;
 
+/// Runs AI_MIND's searches on a worker thread, so the window stays responsive while the AI thinks.
+shared_ptr<SearchJob> AI_JOB;
+
+/// Last search depth shown in the window title (-1 = none).
+int shownSearchDepth = -1;
+
+/// Moves (squares) AI_JOB is choosing between; its result is an index into this list.
+vector<int> aiJobMoves;
+
+/// While white thinks, AI_JOB searches black's answer to the reply it predicted for white ("pondering").
+/// ponderPosition is the position it is searching; if white's move leads there, the search carries on as black's turn.
+bool pondering = false;
+bool ponderHit = false;
+Position ponderPosition = Position::empty();
+
+/// How pondering went for the move being searched ("hit", "miss", or "" if there was no ponder search), for the AI's move report.
+string ponderResult;
+
 shared_ptr<GameState> gameState;
 
 bool currentTurn = 0; // 1 = white, 0 = black
@@ -87,6 +103,9 @@ void applicationInit();
 
 void endGame();
 
+/// Starts searching (in the background) black's answer to the reply the last search expects from white.
+void startPondering();
+
 /// Passes the turn to the given player - startTurn() must be called separately.
 ///@param toWho Which player to pass the turn to.
 void passTurn(shared_ptr<Player>& toWho);
@@ -102,10 +121,6 @@ time_t startTime = -1;
 int winWidth = 800,
     winHeight = 800;
 
-float Board::pixelToWorldRatio;
-float Board::worldToPixelRatio;
-float Board::drawInPixelScale;
-
 RGBColor WHITE = RGBColor{1, 1, 1};
 RGBColor BLACK = RGBColor{0, 0, 0};
 
@@ -114,6 +129,7 @@ void endGame() {
     unsigned int numBlackTiles, numWhiteTiles;
     vector<vector<shared_ptr<Tile>>> blackTiles, whiteTiles;
     gameOver = 1; // game over
+    AI_JOB->cancel(); // a search started while pondering has nothing left to answer
     
     // how many tiles does each player control?
     numBlackTiles = gameState->getPlayerTiles(playerBlack, blackTiles);
@@ -208,6 +224,7 @@ void startTurn(shared_ptr<Player>& whoseTurn) {
 
 void myDisplayFunc(void)
 {
+    PROFILE_ZONE("myDisplayFunc");
     //    This clears the buffer(s) we draw into.
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -314,8 +331,20 @@ void myKeyHandler(unsigned char c, int x, int y)
         case 'q':
         case 'Q':
         case 27:
+            AI_JOB->cancel(); // don't leave the search thread running while the program exits
             exit(0);
             break;
+            
+            // press 'p' to dump the profiled zones so far (frames & searches on one timeline)
+        case 'p':
+        case 'P':
+            if (!profiler::enabled())
+                cout << "Profiling isn't compiled in (build with OTHELLO_PROFILE defined)" << endl;
+            else if (profiler::writeChromeTrace(TRACE_PATH))
+                cout << "Profile written to " << TRACE_PATH << " (open it in chrome://tracing or ui.perfetto.dev)" << endl;
+            else
+                cout << "Couldn't write " << TRACE_PATH << endl;
+            break;
 
         default:
             break;
@@ -337,6 +366,7 @@ void myKeyUpHandler(unsigned char c, int x, int y)
 
 void myTimerFunc(int value)
 {
+    PROFILE_ZONE("myTimerFunc");
     // the timer function is run between every frame
     static int frameIndex=0;
     static chrono::high_resolution_clock::time_point lastTime = chrono::high_resolution_clock::now();
@@ -355,21 +385,81 @@ void myTimerFunc(int value)
         } else {
             if (!turnStarted)
                 startTurn(playerBlack);
-            // black's (AI) turn logic
-            if (cur_ai_turn_wait >= SECS_BETWEEN_AI_MOVES) {
-                // compute black's best move and play it
-                unsigned int bestMoveIndex = AI_MIND->bestMoveMinimax(playerBlack, gameBoard, gameState, blackPlayableTiles, MINIMAX_DEPTH);
-                
-                // for the tile flip animation to show, we need to reset currenttime after picking the move, because it can take a few seconds
-                currentTime = chrono::high_resolution_clock::now();
+            // black's (AI) turn logic: the search runs on a worker thread while frames keep being drawn, and is only polled here
+            unsigned int bestMoveIndex;
+            if (!currentTurn && !blackPlayableTiles.empty()) {
+                Position aiPosition = gameState->getPosition();
+                aiPosition.toMove = gameState->sideOf(playerBlack);
+                if (pondering) {
+                    // the search started during white's turn is only any use if white played the predicted move
+                    pondering = false;
+                    ponderHit = (aiPosition == ponderPosition);
+                    if (!ponderHit)
+                        AI_JOB->cancel(); // the new search still starts from the transposition table the ponder search filled
+                    ponderResult = ponderHit ? "hit" : "miss";
+                }
+                if (!AI_JOB->isRunning()) {
+                    aiJobMoves.clear();
+                    for (auto tile : blackPlayableTiles) {
+                        aiJobMoves.push_back(squareOf(tile->getPos()));
+                    }
+                    AI_JOB->start(aiPosition, aiJobMoves, SearchLimits{MAX_SEARCH_DEPTH, AI_SECS_PER_MOVE, AI_NODES_PER_MOVE});
+                }
+            }
+            // a ponder search has no time limit of its own: it gets the usual thinking time, counting the time white spent thinking
+            if (ponderHit && AI_JOB->isRunning() && (AI_JOB->elapsedSeconds() >= AI_SECS_PER_MOVE) && (AI_JOB->getProgress().iterationsDone > 0))
+                AI_JOB->stop();
+            if (AI_JOB->isRunning() && ((int)AI_JOB->getProgress().iterationsDone - 1 != shownSearchDepth)) {
+                shownSearchDepth = (int)AI_JOB->getProgress().iterationsDone - 1;
+                string title = string(WIN_TITLE) + " - AI thinking";
+                if (shownSearchDepth >= 0)
+                    title += " (depth " + to_string(shownSearchDepth) + ")";
+                glutSetWindowTitle(title.c_str());
+            }
+            if ((cur_ai_turn_wait >= SECS_BETWEEN_AI_MOVES) && AI_JOB->poll(bestMoveIndex)) {
+                // play the move the AI chose
+                glutSetWindowTitle(WIN_TITLE);
+                shownSearchDepth = -1;
+                ponderHit = false;
                 
-                TilePoint bestMoveLoc = blackPlayableTiles[bestMoveIndex]->getPos();
+                TilePoint bestMoveLoc = tileOf(aiJobMoves[bestMoveIndex]);
                 shared_ptr<Tile> bestMove = gameBoard->getBoardTile(bestMoveLoc);
                 shared_ptr<Disc> newPiece = gameState->placePiece(playerBlack, bestMove);
                 allObjects.push_back(newPiece);
                 cur_ai_turn_wait = 0;
                 passTurn(playerWhite);
-            } else {
+                
+                // one line per move: what the search found, how it went (nodes per thread, ordering, table hits) and whether pondering paid off
+                const SearchInfo& info = AI_MIND->getLastSearchInfo();
+                if (info.fromBook)
+                    cout << "AI: book move, searched to depth " << info.depthReached << ", score " << info.score << ", found in " << fixed << setprecision(6) << info.seconds << "s";
+                else if (info.solved)
+                    cout << "AI: solved " << info.depthReached << " empties, final disc difference " << info.score << ", " << info.nodes << " nodes in " << fixed << setprecision(3) << info.seconds << "s";
+                else {
+                    cout << "AI: depth " << info.depthReached << ", score " << info.score << ", " << info.nodes << " nodes in " << fixed << setprecision(3) << info.seconds << "s ("
+                         << setprecision(0) << info.nodesPerSecond() << " nodes/s, EBF " << setprecision(2) << info.effectiveBranchingFactor();
+                    if (info.detailed)
+                        cout << ", " << info.leafEvaluations << " leaves, " << setprecision(1) << info.firstMoveCutoffRate() * 100 << "% first-move cutoffs";
+                    cout << ", " << setprecision(1) << info.table.hitRate() * 100 << "% table hits";
+                    if (info.threadNodes.size() > 1) {
+                        cout << ", nodes per thread";
+                        for (size_t i = 0; i < info.threadNodes.size(); i++) {
+                            cout << (i ? "/" : " ") << info.threadNodes[i];
+                        }
+                    }
+                    cout << ")";
+                }
+                if (!ponderResult.empty())
+                    cout << ", ponder " << ponderResult;
+                cout << ", pv";
+                for (int sq : info.principalVariation) {
+                    cout << " " << squareName(sq);
+                }
+                cout << endl;
+                ponderResult.clear();
+                
+                startPondering();
+            } else if (cur_ai_turn_wait < SECS_BETWEEN_AI_MOVES) {
                 cur_ai_turn_wait += dt;
             }
             
@@ -390,6 +480,35 @@ void myTimerFunc(int value)
     }
 }
 
+void startPondering() {
+    const SearchInfo& info = AI_MIND->getLastSearchInfo();
+    Position pos = gameState->getPosition();
+    pos.toMove = gameState->sideOf(playerWhite);
+    
+    // the principal variation's second move is the reply the AI expects; if white can't move, black's next position is already known
+    Bitboard whiteMoves = pos.legalMoves();
+    if (whiteMoves == 0) {
+        pos.pass();
+    } else if ((info.principalVariation.size() >= 2) && (whiteMoves & squareBit(info.principalVariation[1]))) {
+        pos.play(info.principalVariation[1]);
+    } else {
+        return;
+    }
+    
+    Bitboard blackMoves = pos.legalMoves();
+    if (blackMoves == 0)
+        return;
+    aiJobMoves.clear();
+    while (blackMoves) {
+        aiJobMoves.push_back(popLowestSquare(blackMoves));
+    }
+    
+    // no time limit: the search runs until white moves
+    ponderPosition = pos;
+    pondering = true;
+    AI_JOB->start(pos, aiJobMoves, SearchLimits{MAX_SEARCH_DEPTH, 0, 0});
+}
+
 void myMouseHandler(int button, int state, int ix, int iy)
 {
     switch (button)
@@ -438,7 +557,17 @@ void applicationInit()
     gameState = make_shared<GameState>(playerWhite, playerBlack, gameBoard);
     
     // AiMind implements Minimax and Game Score Heuristic
-    AI_MIND = make_shared<AiMind>(NUM_DISC_WEIGHT, MOBILITY_WEIGHT, STABILITY_WEIGHT, CORNER_WEIGHT, CORNER_ADJ_WEIGHT, NUM_FRONTIER_WEIGHT, DEFAULT_TILE_COLOR);
+    AI_MIND = makeDefaultMind();
+    if (AI_MIND->getPatternEvaluator().load(EVAL_PATH))
+        cout << "AI: pattern tables loaded from " << EVAL_PATH << endl;
+    auto book = make_shared<OpeningBook>();
+    if (book->open(BOOK_PATH)) {
+        AI_MIND->setOpeningBook(book);
+        cout << "AI: opening book " << BOOK_PATH << " (" << book->size() << " positions)" << endl;
+    } else {
+        cout << "AI: no opening book at " << BOOK_PATH << " (run othello-cli --build-book to make one)" << endl;
+    }
+    AI_JOB = make_shared<SearchJob>(AI_MIND);
     
     // 4 starting pieces (discs)
     gameState->addGamePiece(TilePoint{4, 4}, playerBlack, allObjects);
@@ -481,6 +610,7 @@ int main(int argc, char * argv[])
     //    "lose control" over its execution.  The callback functions that
     //    we set up earlier will be called when the corresponding event
     //    occurs
+    PROFILE_THREAD("main");
     glutMainLoop();
     
     //    This will never be executed (the exit point will be in one of the
@@ -0,0 +1,418 @@
+//
+//  main.cpp
+//  OthelloBench
+//
+//  Microbenchmarks of the hot paths the game & AI run every turn, over a fixed set of opening, midgame and endgame positions.
+//  Each benchmark is timed in many samples (after a warm-up pass) and summarised as mean / median / p99 time per call, written as JSON
+//  so runs on different commits can be compared. No window is opened: the game's Board, Tiles & GameState are made off screen.
+//  They draw with OpenGL though, so their benchmarks are only built with the game (OTHELLO_BENCH_GAME); without it only the
+//  engine's are run, and othello-bench needs nothing but the engine library.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AiMind.hpp"
+#include "AiConfig.hpp"
+#ifdef OTHELLO_BENCH_GAME
+#include "Board.hpp"
+#include "GameState.hpp"
+#include "Player.hpp"
+#include "Tile.hpp"
+#endif
+
+using namespace std;
+using namespace othello;
+
+/// Positions of each game phase in the corpus, and how many empty squares the positions of each phase have.
+const unsigned int POSITIONS_PER_PHASE = 16;
+const int OPENING_EMPTIES = 50;
+const int MIDGAME_EMPTIES = 32;
+const int ENDGAME_EMPTIES = 14;
+
+/// Depths minimax is timed at.
+const vector<unsigned int> MINIMAX_DEPTHS = {2, 4, 6};
+
+/// Each benchmark takes samples until it has at least MIN_SAMPLES and has spent MIN_SECONDS timing them,
+/// or until it reaches MAX_SAMPLES or MAX_SECONDS. "--quick" divides the times by QUICK_DIVISOR.
+const size_t MIN_SAMPLES = 50;
+const size_t MAX_SAMPLES = 20000;
+const double MIN_SECONDS = 0.5;
+const double MAX_SECONDS = 5.0;
+const double QUICK_DIVISOR = 10;
+
+/// Passes over the corpus are repeated within a sample until it lasts at least this long, so clock resolution doesn't matter.
+const double MIN_SAMPLE_SECONDS = 0.0005;
+
+/// Transposition table of the AI timed by the minimax benchmarks (cleared before each sample along with the killer moves & history, so every sample searches the same tree).
+const size_t BENCH_TT_SIZE_MB = 4;
+
+#ifdef OTHELLO_BENCH_GAME
+const RGBColor DEFAULT_TILE_COLOR = RGBColor{0.2f, 1.f, 0.4f};
+
+
+/// A corpus position set up as the game holds it: a board of tiles, players and a GameState.
+struct Fixture {
+    Position pos;
+    shared_ptr<Player> playerNull;
+    shared_ptr<Player> playerWhite;
+    shared_ptr<Player> playerBlack;
+    shared_ptr<Board> board;
+    shared_ptr<GameState> state;
+
+    /// Player whose turn it is in pos.
+    shared_ptr<Player> toMove;
+
+    /// Tiles toMove can play on, as getPlayableTiles lists them.
+    vector<shared_ptr<Tile>> moves;
+
+    /// Tiles with a disc on them.
+    vector<shared_ptr<Tile>> discs;
+};
+
+
+Fixture makeFixture(const Position& pos) {
+    Fixture f;
+    f.pos = pos;
+    f.playerNull = make_shared<Player>(RGBColor{-1, -1, -1});
+    f.playerWhite = make_shared<Player>(RGBColor{1, 1, 1});
+    f.playerBlack = make_shared<Player>(RGBColor{0, 0, 0});
+    f.board = make_shared<Board>(DEFAULT_TILE_COLOR, f.playerNull);
+    f.state = make_shared<GameState>(f.playerWhite, f.playerBlack, f.board);
+    for (int sq = 0; sq < NUM_SQUARES; sq++) {
+        Side owner;
+        if (pos.ownerOf(sq, owner)) {
+            f.state->addGamePiece(tileOf(sq), (owner == SIDE_BLACK) ? f.playerBlack : f.playerWhite);
+            TilePoint at = tileOf(sq);
+            f.discs.push_back(f.state->getBoardTile(at));
+        }
+    }
+    f.toMove = (pos.toMove == SIDE_BLACK) ? f.playerBlack : f.playerWhite;
+    f.state->getPlayableTiles(f.toMove, f.moves);
+    return f;
+}
+#endif
+
+
+/// One game phase of the corpus.
+struct Phase {
+    string name;
+    int empties;
+    vector<Position> positions;
+};
+
+
+/// The corpus: from fixed pseudo-random games, the position each game reaches with each phase's number of empties
+/// (if the side to move can move there), until every phase has POSITIONS_PER_PHASE. The same on every run.
+vector<Phase> makeCorpus() {
+    vector<Phase> phases = {{"opening", OPENING_EMPTIES, {}}, {"midgame", MIDGAME_EMPTIES, {}}, {"endgame", ENDGAME_EMPTIES, {}}};
+    uint32_t choice = 2024;
+    auto full = [&phases]() {
+        for (const Phase& phase : phases) {
+            if (phase.positions.size() < POSITIONS_PER_PHASE)
+                return false;
+        }
+        return true;
+    };
+    while (!full()) {
+        Position pos = Position::initial();
+        while (true) {
+            Bitboard moves = pos.legalMoves();
+            if (moves == 0) {
+                pos.pass();
+                moves = pos.legalMoves();
+                if (moves == 0)
+                    break;
+            }
+            for (Phase& phase : phases) {
+                if ((pos.numEmpties() == phase.empties) && (phase.positions.size() < POSITIONS_PER_PHASE))
+                    phase.positions.push_back(pos);
+            }
+            choice = choice * 1103515245 + 12345;
+            unsigned int skip = (choice >> 16) % popCount(moves);
+            for (unsigned int i = 0; i < skip; i++) {
+                popLowestSquare(moves);
+            }
+            pos.play(lowestSquare(moves));
+        }
+    }
+    return phases;
+}
+
+
+/// Timings of one benchmark on one phase, per call of the function benchmarked.
+struct BenchResult {
+    string name;
+    string phase;
+
+    /// Calls per pass over the phase's positions.
+    uint64_t callsPerPass;
+
+    /// Passes timed together as one sample.
+    uint64_t passesPerSample;
+
+    size_t samples;
+
+    /// Nanoseconds per call.
+    double mean;
+    double median;
+    double p99;
+    double min;
+    double max;
+};
+
+
+/// Times 'pass' (one pass over a phase's positions, making 'callsPerPass' calls) in samples, calling 'prepare' (untimed) before each one.
+/// Benchmarks that change their fixtures (or need a fresh transposition table) prepare every pass, so each sample is a single pass.
+BenchResult measure(const string& name, const string& phase, uint64_t callsPerPass, const function<void()>& pass, const function<void()>& prepare, double timeScale) {
+    BenchResult result = BenchResult{name, phase, callsPerPass, 1, 0, 0, 0, 0, 0, 0};
+    typedef chrono::steady_clock Clock;
+
+    // warm up (caches, branch predictors, lazily built tables), and find how many passes make a long enough sample
+    if (prepare)
+        prepare();
+    Clock::time_point start = Clock::now();
+    pass();
+    double passSeconds = chrono::duration<double>(Clock::now() - start).count();
+    if (!prepare && (passSeconds < MIN_SAMPLE_SECONDS))
+        result.passesPerSample = (uint64_t)ceil(MIN_SAMPLE_SECONDS / max(passSeconds, 1e-9));
+
+    vector<double> perCall;
+    double timedSeconds = 0;
+    while ((perCall.size() < MAX_SAMPLES) && (timedSeconds < MAX_SECONDS / timeScale)
+           && ((perCall.size() < MIN_SAMPLES) || (timedSeconds < MIN_SECONDS / timeScale))) {
+        if (prepare)
+            prepare();
+        start = Clock::now();
+        for (uint64_t p = 0; p < result.passesPerSample; p++) {
+            pass();
+        }
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+        timedSeconds += seconds;
+        perCall.push_back(seconds * 1e9 / (double)(result.passesPerSample * callsPerPass));
+    }
+
+    sort(perCall.begin(), perCall.end());
+    result.samples = perCall.size();
+    double sum = 0;
+    for (double t : perCall) {
+        sum += t;
+    }
+    result.mean = sum / perCall.size();
+    result.median = (perCall.size() % 2) ? perCall[perCall.size() / 2] : (perCall[perCall.size() / 2 - 1] + perCall[perCall.size() / 2]) / 2;
+    result.p99 = perCall[(size_t)ceil(0.99 * perCall.size()) - 1];
+    result.min = perCall.front();
+    result.max = perCall.back();
+    return result;
+}
+
+
+/// First line of a file, or "" if it can't be read.
+string readLine(const string& path) {
+    ifstream in(path);
+    string line;
+    getline(in, line);
+    return line;
+}
+
+
+/// Value of the first "key : value" line of /proc/cpuinfo starting with 'key' ("" if there's none, e.g. not on Linux).
+string cpuInfo(const string& key) {
+    ifstream in("/proc/cpuinfo");
+    string line;
+    while (getline(in, line)) {
+        if (line.compare(0, key.size(), key) == 0) {
+            size_t colon = line.find(':');
+            if (colon != string::npos)
+                return line.substr(line.find_first_not_of(" \t", colon + 1));
+        }
+    }
+    return "";
+}
+
+
+/// Current clock of CPU 0 in MHz as the OS reports it, or 0 if it doesn't.
+double currentMHz() {
+    string khz = readLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
+    if (!khz.empty())
+        return stod(khz) / 1000;
+    string mhz = cpuInfo("cpu MHz");
+    return mhz.empty() ? 0 : stod(mhz);
+}
+
+
+/// Escapes a string for a JSON string literal.
+string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if ((c == '"') || (c == '\\'))
+            out += '\\';
+        if ((unsigned char)c >= 0x20)
+            out += c;
+    }
+    return out + "\"";
+}
+
+
+int main(int argc, char * argv[])
+{
+    // "othello-bench [output.json] [--quick]": JSON goes to the file (or stdout), progress to stderr
+    string outPath;
+    double timeScale = 1;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--quick")
+            timeScale = QUICK_DIVISOR;
+        else
+            outPath = argv[i];
+    }
+
+    double startMHz = currentMHz();
+    vector<Phase> corpus = makeCorpus();
+
+    AiMind mind(NUM_DISC_WEIGHT, MOBILITY_WEIGHT, STABILITY_WEIGHT, CORNER_WEIGHT, CORNER_ADJ_WEIGHT, NUM_FRONTIER_WEIGHT);
+    mind.configureTranspositionTable(BENCH_TT_SIZE_MB, TT_POLICY);
+    mind.setSearchThreads(1);
+
+    vector<BenchResult> results;
+    auto record = [&results](const BenchResult& result) {
+        cerr << result.phase << " " << result.name << ": median " << result.median << " ns, p99 " << result.p99 << " ns (" << result.samples << " samples)" << endl;
+        results.push_back(result);
+    };
+
+    for (const Phase& phase : corpus) {
+#ifdef OTHELLO_BENCH_GAME
+        vector<Fixture> fixtures;
+        uint64_t numMoves = 0, numDiscs = 0;
+        for (const Position& pos : phase.positions) {
+            fixtures.push_back(makeFixture(pos));
+            numMoves += fixtures.back().moves.size();
+            numDiscs += fixtures.back().discs.size();
+        }
+
+        vector<shared_ptr<Tile>> tiles;
+        record(measure("getPlayableTiles", phase.name, fixtures.size(), [&]() {
+            for (Fixture& f : fixtures) {
+                tiles.clear();
+                f.state->getPlayableTiles(f.toMove, tiles);
+            }
+        }, nullptr, timeScale));
+
+        vector<vector<shared_ptr<Tile>>> flanked;
+        record(measure("getFlankingTiles", phase.name, numMoves, [&]() {
+            for (Fixture& f : fixtures) {
+                for (shared_ptr<Tile>& tile : f.moves) {
+                    flanked.clear();
+                    f.state->getFlankingTiles(tile, f.toMove, flanked);
+                }
+            }
+        }, nullptr, timeScale));
+
+        // placing changes the board, so every sample places the first move on freshly made fixtures
+        vector<Fixture> fresh;
+        record(measure("placePiece", phase.name, fixtures.size(), [&]() {
+            for (Fixture& f : fresh) {
+                f.state->placePiece(f.toMove, f.moves.front(), true);
+            }
+        }, [&]() {
+            fresh.clear();
+            for (const Position& pos : phase.positions) {
+                fresh.push_back(makeFixture(pos));
+            }
+        }, timeScale));
+
+        record(measure("discIsStable", phase.name, numDiscs, [&]() {
+            for (Fixture& f : fixtures) {
+                for (shared_ptr<Tile>& tile : f.discs) {
+                    f.state->discIsStable(tile);
+                }
+            }
+        }, nullptr, timeScale));
+
+        record(measure("evalGamestateScore", phase.name, fixtures.size(), [&]() {
+            for (Fixture& f : fixtures) {
+                f.state->evalGamestateScore(mind, f.toMove);
+            }
+        }, nullptr, timeScale));
+#endif
+
+        for (unsigned int depth : MINIMAX_DEPTHS) {
+            record(measure("minimax depth " + to_string(depth), phase.name, phase.positions.size(), [&]() {
+                for (const Position& pos : phase.positions) {
+                    mind.minimax(true, depth, pos, pos.toMove, -SCORE_INFINITY, SCORE_INFINITY);
+                }
+            }, [&]() {
+                mind.clearSearchState();
+            }, timeScale));
+        }
+    }
+
+    double endMHz = currentMHz();
+
+    // anything that makes timings from different runs less comparable
+    vector<string> notes;
+    string governor = readLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    if (governor.empty())
+        notes.push_back("CPU frequency scaling governor unknown: timings may depend on the clock speed at the time");
+    else if (governor != "performance")
+        notes.push_back("CPU frequency scaling governor is '" + governor + "', not 'performance': the clock speed may change during the run");
+    if ((startMHz == 0) || (endMHz == 0))
+        notes.push_back("the OS doesn't report the current CPU clock speed");
+    else if (fabs(endMHz - startMHz) > 0.05 * startMHz)
+        notes.push_back("CPU clock changed from " + to_string((int)startMHz) + " to " + to_string((int)endMHz) + " MHz during the run");
+    if (timeScale != 1)
+        notes.push_back("--quick run: fewer samples, so the p99 values are noisier");
+#ifndef OTHELLO_BENCH_GAME
+    notes.push_back("built without the game (no OpenGL or GLUT): only the engine's benchmarks were run");
+#endif
+
+    ostringstream json;
+    json << fixed << setprecision(1);
+    json << "{\n  \"machine\": {\n"
+         << "    \"cpu\": " << jsonString(cpuInfo("model name")) << ",\n"
+         << "    \"hardwareThreads\": " << thread::hardware_concurrency() << ",\n"
+         << "    \"mhzAtStart\": " << startMHz << ",\n"
+         << "    \"mhzAtEnd\": " << endMHz << ",\n"
+         << "    \"governor\": " << jsonString(governor) << ",\n"
+         << "    \"compiler\": " << jsonString(__VERSION__) << ",\n"
+         << "    \"notes\": [";
+    for (size_t i = 0; i < notes.size(); i++) {
+        json << (i ? ", " : "") << jsonString(notes[i]);
+    }
+    json << "]\n  },\n  \"corpus\": {";
+    for (size_t i = 0; i < corpus.size(); i++) {
+        json << (i ? ", " : "") << jsonString(corpus[i].name) << ": {\"positions\": " << corpus[i].positions.size() << ", \"empties\": " << corpus[i].empties << "}";
+    }
+    json << "},\n  \"unit\": \"ns per call\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        json << "    {\"name\": " << jsonString(r.name) << ", \"phase\": " << jsonString(r.phase)
+             << ", \"callsPerPass\": " << r.callsPerPass << ", \"passesPerSample\": " << r.passesPerSample << ", \"samples\": " << r.samples
+             << ", \"iterations\": " << r.callsPerPass * r.passesPerSample * r.samples
+             << ", \"mean\": " << r.mean << ", \"median\": " << r.median << ", \"p99\": " << r.p99 << ", \"min\": " << r.min << ", \"max\": " << r.max << "}"
+             << ((i + 1 < results.size()) ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+
+    if (outPath.empty()) {
+        cout << json.str();
+    } else {
+        ofstream out(outPath);
+        out << json.str();
+        if (!out) {
+            cerr << "Couldn't write " << outPath << endl;
+            return 1;
+        }
+        cerr << "Wrote " << outPath << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,339 @@
+//
+//  main.cpp
+//  OthelloCLI
+//
+//  Headless front end to the engine library: plays, searches and benchmarks positions from the command line, with no window
+//  (e.g. on a server). Positions are written as in Position::toText, squares as in squareName.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+
+#include "AiMind.hpp"
+#include "AiConfig.hpp"
+#include "SearchBenchmark.hpp"
+#include "OpeningBook.hpp"
+#include "BookBuilder.hpp"
+#include "Perft.hpp"
+#include "Profiler.hpp"
+
+using namespace std;
+using namespace othello;
+
+// the AI plays with the game's settings (AiConfig.hpp); commands that take a time or depth override its search limits
+
+/// Depth searched by "--bench-threads" when none is given, and the thread counts it compares.
+const unsigned int BENCH_DEPTH = 8;
+const vector<unsigned int> BENCH_THREAD_COUNTS = {1, 2, 4, 8, 16};
+
+/// Positions evaluated each way by "--bench-eval" when no count is given.
+const size_t BENCH_EVAL_POSITIONS = 1000000;
+
+/// Depth counted by "--perft" and "--perft-validate" when none is given.
+const unsigned int PERFT_DEPTH = 9;
+const unsigned int PERFT_VALIDATE_DEPTH = 11;
+
+/// Plies covered and depth searched by "--build-book" when none are given.
+const unsigned int BOOK_PLIES = 12;
+const unsigned int BOOK_DEPTH = 10;
+
+
+void printUsage() {
+    cout << "usage: othello-cli <command> [args]\n"
+         << "  --search [position] [seconds] [depth]   best move for the side to move (default: the starting position)\n"
+         << "  --play [black|white|none] [seconds]     play a game on the terminal; you play the given color (none = AI against itself)\n"
+         << "  --perft [depth] [position] [threads] [bulk|full]\n"
+         << "                                          count the positions depth plies ahead, and how fast (default " << PERFT_DEPTH << ", bulk)\n"
+         << "  --perft-divide [depth] [position]       the same count, per move\n"
+         << "  --perft-validate [depth] [threads]      compare counts from the starting position with the published ones\n"
+         << "  --bench-threads [depth]                 search the benchmark positions with " << BENCH_THREAD_COUNTS.size() << " thread counts\n"
+         << "  --bench-eval [positions]                compare single & batch evaluation\n"
+         << "  --build-book [plies] [depth]            write an opening book to " << BOOK_PATH << "\n"
+         << "  --trace <file> <command> [args]         run the command, then write the profiled zones to file as a Chrome trace\n"
+         << "                                          (only recorded when built with OTHELLO_PROFILE defined)\n"
+         << "positions are 64 squares in order a1 b1 ... h8 ('X' black, 'O' white, '-' empty), then the side to move (X or O)" << endl;
+}
+
+
+/// Creates the AI with the game's settings, loading the pattern tables & opening book if they're there.
+shared_ptr<AiMind> makeMind(bool useBook) {
+    shared_ptr<AiMind> mind = makeDefaultMind();
+    mind->getPatternEvaluator().load(EVAL_PATH);
+    if (useBook) {
+        auto book = make_shared<OpeningBook>();
+        if (book->open(BOOK_PATH))
+            mind->setOpeningBook(book);
+    }
+    return mind;
+}
+
+
+/// Draws the board with the given moves marked '*'.
+void printBoard(const Position& pos, Bitboard marked) {
+    cout << "  a b c d e f g h" << endl;
+    for (int y = 0; y < 8; y++) {
+        cout << (y + 1);
+        for (int x = 0; x < 8; x++) {
+            int sq = y * 8 + x;
+            Side owner;
+            char c = pos.ownerOf(sq, owner) ? ((owner == SIDE_BLACK) ? 'X' : 'O') : ((marked & squareBit(sq)) ? '*' : '-');
+            cout << ' ' << c;
+        }
+        cout << endl;
+    }
+    cout << "X " << pos.count(SIDE_BLACK) << "  O " << pos.count(SIDE_WHITE) << endl;
+}
+
+
+/// Legal moves of the side to move, as squares in ascending order (the order the game lists its playable tiles in).
+vector<int> rootMovesOf(const Position& pos) {
+    vector<int> moves;
+    for (Bitboard b = pos.legalMoves(); b; ) {
+        moves.push_back(popLowestSquare(b));
+    }
+    return moves;
+}
+
+
+/// Searches 'pos' and prints what the search found. Returns the chosen square.
+int searchAndReport(AiMind& mind, const Position& pos, const SearchLimits& limits) {
+    vector<int> rootMoves = rootMovesOf(pos);
+    unsigned int best = mind.bestMove(pos, rootMoves, limits);
+    const SearchInfo& info = mind.getLastSearchInfo();
+    cout << "move " << squareName(rootMoves[best]) << "  score " << info.score << "  depth " << info.depthReached
+         << "  nodes " << info.nodes << "  time " << info.seconds << "s  nps " << (uint64_t)info.nodesPerSecond();
+    if (!info.iterations.empty())
+        cout << "  ebf " << info.effectiveBranchingFactor();
+    if (info.detailed)
+        cout << "  leaves " << info.leafEvaluations << "  first-move cutoffs " << info.firstMoveCutoffRate() * 100 << "%";
+    if (info.table.probes)
+        cout << "  table hits " << info.table.hitRate() * 100 << "%";
+    if (info.solved)
+        cout << "  (solved)";
+    if (info.fromBook)
+        cout << "  (book)";
+    cout << "  pv";
+    for (int sq : info.principalVariation) {
+        cout << ' ' << squareName(sq);
+    }
+    cout << endl;
+    return rootMoves[best];
+}
+
+
+/// Prints the nodes & time of each iteration of the last search, and its cutoffs per ply if they were counted.
+void printSearchStats(const SearchInfo& info) {
+    for (const IterationInfo& iter : info.iterations) {
+        cout << "depth " << iter.depth << "  score " << iter.score << "  nodes " << iter.nodes << "  time " << iter.seconds << "s" << endl;
+    }
+    for (size_t ply = 1; ply < info.plies.size(); ply++) {
+        const PlyStats& stats = info.plies[ply];
+        cout << "ply " << ply << "  nodes " << stats.nodes << "  cutoffs " << stats.cutoffs;
+        if (stats.cutoffs)
+            cout << "  first move " << (double)stats.firstMoveCutoffs / stats.cutoffs * 100 << "%";
+        cout << endl;
+    }
+}
+
+
+/// Reads the optional position argument at argv[index] ("start" or missing = the starting position). Returns false if it isn't one.
+bool positionArg(int argc, char* argv[], int index, Position& pos) {
+    pos = Position::initial();
+    if ((argc <= index) || (string(argv[index]) == "start"))
+        return true;
+    if (Position::fromText(argv[index], pos))
+        return true;
+    cerr << "Not a position: " << argv[index] << endl;
+    return false;
+}
+
+
+int runSearch(int argc, char* argv[]) {
+    Position pos;
+    if (!positionArg(argc, argv, 2, pos))
+        return 1;
+    double seconds = (argc > 3) ? stod(argv[3]) : AI_SECS_PER_MOVE;
+    unsigned int depth = (argc > 4) ? (unsigned int)stoul(argv[4]) : MAX_SEARCH_DEPTH;
+    if (pos.legalMoves() == 0) {
+        cerr << "The side to move has no legal move" << endl;
+        return 1;
+    }
+    shared_ptr<AiMind> mind = makeMind(true);
+    printBoard(pos, pos.legalMoves());
+    searchAndReport(*mind, pos, SearchLimits{depth, seconds, AI_NODES_PER_MOVE});
+    printSearchStats(mind->getLastSearchInfo());
+    return 0;
+}
+
+
+int runPlay(int argc, char* argv[]) {
+    string human = (argc > 2) ? string(argv[2]) : "black";
+    if ((human != "black") && (human != "white") && (human != "none")) {
+        printUsage();
+        return 1;
+    }
+    double seconds = (argc > 3) ? stod(argv[3]) : AI_SECS_PER_MOVE;
+    shared_ptr<AiMind> mind = makeMind(true);
+
+    Position pos = Position::initial();
+    while (true) {
+        Bitboard moves = pos.legalMoves();
+        if (moves == 0) {
+            // no valid moves: the turn passes, and the game is over if the other player can't move either
+            if (pos.isGameOver())
+                break;
+            cout << ((pos.toMove == SIDE_BLACK) ? "X" : "O") << " passes" << endl;
+            pos.pass();
+            continue;
+        }
+        bool humanToMove = ((human == "black") && (pos.toMove == SIDE_BLACK)) || ((human == "white") && (pos.toMove == SIDE_WHITE));
+        cout << endl;
+        printBoard(pos, humanToMove ? moves : 0);
+        cout << ((pos.toMove == SIDE_BLACK) ? "X" : "O") << " to move" << endl;
+
+        int sq = NO_SQUARE;
+        if (humanToMove) {
+            string line;
+            while (sq == NO_SQUARE) {
+                cout << "> " << flush;
+                if (!getline(cin, line) || (line == "quit"))
+                    return 0;
+                if (!parseSquare(line, sq) || !(moves & squareBit(sq))) {
+                    cout << "Not a legal move (e.g. " << squareName(lowestSquare(moves)) << ")" << endl;
+                    sq = NO_SQUARE;
+                }
+            }
+        } else {
+            sq = searchAndReport(*mind, pos, SearchLimits{MAX_SEARCH_DEPTH, seconds, AI_NODES_PER_MOVE});
+        }
+        pos.play(sq);
+    }
+
+    cout << endl;
+    printBoard(pos, 0);
+    int diff = pos.count(SIDE_BLACK) - pos.count(SIDE_WHITE);
+    cout << ((diff > 0) ? "BLACK WINS" : (diff < 0) ? "WHITE WINS" : "DRAW") << endl;
+    return 0;
+}
+
+
+int runPerft(int argc, char* argv[]) {
+    unsigned int depth = (argc > 2) ? (unsigned int)stoul(argv[2]) : PERFT_DEPTH;
+    Position pos;
+    if (!positionArg(argc, argv, 3, pos))
+        return 1;
+    unsigned int threads = (argc > 4) ? (unsigned int)stoul(argv[4]) : thread::hardware_concurrency();
+    bool bulk = (argc <= 5) || (string(argv[5]) != "full");
+    PerftResult result = runPerft(pos, depth, threads, bulk);
+    cout << "perft " << depth << ": " << result.leaves << " leaves in " << result.seconds << "s, "
+         << (uint64_t)result.leavesPerSecond << " leaves/s (" << threads << " threads, " << (bulk ? "bulk" : "full") << ")" << endl;
+    if ((pos == Position::initial()) && (depth < perftReferenceCounts().size()) && (result.leaves != perftReferenceCounts()[depth])) {
+        cout << "WRONG: expected " << perftReferenceCounts()[depth] << endl;
+        return 1;
+    }
+    return 0;
+}
+
+
+int runPerftDivide(int argc, char* argv[]) {
+    unsigned int depth = (argc > 2) ? (unsigned int)stoul(argv[2]) : PERFT_DEPTH;
+    Position pos;
+    if (!positionArg(argc, argv, 3, pos))
+        return 1;
+    uint64_t total = 0;
+    for (const auto& move : perftDivide(pos, depth, true)) {
+        cout << ((move.first == NO_SQUARE) ? string("pass") : squareName(move.first)) << ": " << move.second << endl;
+        total += move.second;
+    }
+    cout << "total: " << total << endl;
+    return 0;
+}
+
+
+int runCommand(int argc, char* argv[]) {
+    string command = (argc > 1) ? string(argv[1]) : "";
+
+    if (command == "--search")
+        return runSearch(argc, argv);
+
+    if (command == "--perft")
+        return runPerft(argc, argv);
+
+    if (command == "--perft-divide")
+        return runPerftDivide(argc, argv);
+
+    // "--perft-validate [depth] [threads]" checks move generation & move making against the published counts
+    if (command == "--perft-validate") {
+        unsigned int depth = (argc > 2) ? (unsigned int)stoul(argv[2]) : PERFT_VALIDATE_DEPTH;
+        unsigned int threads = (argc > 3) ? (unsigned int)stoul(argv[3]) : thread::hardware_concurrency();
+        bool ok = validatePerft(depth, threads, &cout);
+        cout << (ok ? "All counts match" : "Some counts are WRONG") << endl;
+        return ok ? 0 : 1;
+    }
+
+    if (command == "--play")
+        return runPlay(argc, argv);
+
+    // "--bench-threads [depth]" measures how the AI's search scales with threads
+    if (command == "--bench-threads") {
+        unsigned int depth = (argc > 2) ? (unsigned int)stoul(argv[2]) : BENCH_DEPTH;
+        AiMind benchMind(NUM_DISC_WEIGHT, MOBILITY_WEIGHT, STABILITY_WEIGHT, CORNER_WEIGHT, CORNER_ADJ_WEIGHT, NUM_FRONTIER_WEIGHT);
+        benchMind.configureTranspositionTable(TT_SIZE_MB, TT_POLICY);
+        cout << "Searching " << benchmarkPositions().size() << " positions to depth " << depth << endl;
+        runThreadBenchmark(benchMind, depth, BENCH_THREAD_COUNTS, &cout);
+        return 0;
+    }
+
+    // "--bench-eval [positions]" compares evaluating positions one at a time with the batch evaluation
+    if (command == "--bench-eval") {
+        size_t numPositions = (argc > 2) ? (size_t)stoull(argv[2]) : BENCH_EVAL_POSITIONS;
+        AiMind benchMind(NUM_DISC_WEIGHT, MOBILITY_WEIGHT, STABILITY_WEIGHT, CORNER_WEIGHT, CORNER_ADJ_WEIGHT, NUM_FRONTIER_WEIGHT);
+        benchMind.getPatternEvaluator().load(EVAL_PATH);
+        cout << "Evaluating " << numPositions << " positions" << endl;
+        runEvalBenchmark(benchMind.getPatternEvaluator(), numPositions, &cout);
+        return 0;
+    }
+
+    // "--build-book [plies] [depth]" searches the opening positions and writes them to BOOK_PATH
+    if (command == "--build-book") {
+        unsigned int plies = (argc > 2) ? (unsigned int)stoul(argv[2]) : BOOK_PLIES;
+        unsigned int depth = (argc > 3) ? (unsigned int)stoul(argv[3]) : BOOK_DEPTH;
+        shared_ptr<AiMind> bookMind = makeMind(false);
+        cout << "Building a " << plies << "-ply opening book at depth " << depth << endl;
+        vector<BookEntry> entries = buildOpeningBook(*bookMind, plies, depth, &cout);
+        if (!OpeningBook::write(BOOK_PATH, entries)) {
+            cout << "Couldn't write " << BOOK_PATH << endl;
+            return 1;
+        }
+        cout << "Wrote " << entries.size() << " positions to " << BOOK_PATH << endl;
+        return 0;
+    }
+
+    printUsage();
+    return (command.empty() || (command == "--help")) ? 0 : 1;
+}
+
+
+int main(int argc, char * argv[])
+{
+    PROFILE_THREAD("main");
+    
+    // "--trace <file> <command> [args]" runs the command with argv[2] taken out, then dumps the profiler
+    if ((argc > 2) && (string(argv[1]) == "--trace")) {
+        string tracePath = argv[2];
+        vector<char*> args(argv, argv + argc);
+        args.erase(args.begin() + 1, args.begin() + 3);
+        int result = runCommand((int)args.size(), args.data());
+        if (!profiler::enabled())
+            cerr << "Profiling isn't compiled in (build with OTHELLO_PROFILE defined), " << tracePath << " has no zones" << endl;
+        if (!profiler::writeChromeTrace(tracePath)) {
+            cerr << "Couldn't write " << tracePath << endl;
+            return 1;
+        }
+        return result;
+    }
+    return runCommand(argc, argv);
+}